@@ -0,0 +1,168 @@
+// layout_bench.cpp : Compares the row-major and Z-order (Morton) grid layouts.
+//   The TileMap benchmarks run with both layouts. The World chunk grid benchmarks use the layout the
+//   program was compiled with, so build both welt_layout_bench and welt_layout_bench_morton to compare them.
+
+#include "../src/world.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+const uint MAP_SIZE = 2048;
+const uint WORLD_SIZE = 1024;
+const uint N_ENTITIES = 100000;
+const uint N_QUERIES = 20000;
+const uint QUERY_RADIUS = 24;
+const uint N_REPEATS = 5;
+
+// An entity that never does anything, for filling the World.
+class BenchEntity : public Ientity {
+public:
+    std::vector<std::size_t> getEntityTypeHash() override { return std::vector<std::size_t>(); }
+
+    EffectedType tick(Iworld<Ientity, EID, Iitem, IID> *worldPointer, const TileMap *map,
+                      const ObjectAndData<Ientity, EID> &selfReference, uint energy) override {
+        return EffectedType::NONE;
+    }
+
+    EffectedType takeDamage(EID attacker, uint damageAmount, DamageType type) override { return EffectedType::NONE; }
+
+    uint getHealth() override { return 1; }
+
+    uint getObjectType() override { return 1; }
+
+    Material getMaterial() override { return M_ENTITY; }
+
+    DisplayID getDisplayID() override { return DCID_ENTITY_SIMPLE; }
+};
+
+// Runs the function N_REPEATS times and returns the fastest run in milliseconds.
+template<class Function>
+double fastestRun(Function &&function) {
+    double best = 0;
+    for (uint i = 0; i < N_REPEATS; i++) {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if ((i == 0) || (ms < best))
+            best = ms;
+    }
+
+    return best;
+}
+
+// Returns random query centers, the same for every run.
+std::vector<Coordinate> queryCenters(uint size) {
+    std::mt19937 random(42);
+    std::uniform_int_distribution<uint> position(0, size - 1);
+
+    std::vector<Coordinate> centers;
+    for (uint i = 0; i < N_QUERIES; i++)
+        centers.push_back(Coordinate{position(random), position(random)});
+
+    return centers;
+}
+
+template<class Layout>
+void benchmarkTileMap(const char *layoutName) {
+    BasicTileMap<Layout> map(MAP_SIZE, MAP_SIZE);
+    for (uint y = 0; y < MAP_SIZE; y++)
+        for (uint x = 0; x < MAP_SIZE; x++)
+            map.setWallMaterial(Coordinate{x, y}, ((x ^ y) & 7) ? M_AIR : M_STONE, 0);
+
+    // Render fill: load the whole map into a DisplayArray.
+    DisplayArray displayArray = map.generateDisplayArray();
+    const double fillMs = fastestRun([&map, &displayArray] { map.loadDisplayArray(displayArray); });
+    delete[] displayArray.displayData;
+
+    // Area query: count the solid walls in squares around random centers.
+    const std::vector<Coordinate> centers = queryCenters(MAP_SIZE);
+    volatile uint sink = 0;
+    const double queryMs = fastestRun([&map, &centers, &sink] {
+        uint nSolid = 0;
+        for (const Coordinate &center : centers) {
+            const uint startX = (center.x > QUERY_RADIUS) ? center.x - QUERY_RADIUS : 0;
+            const uint startY = (center.y > QUERY_RADIUS) ? center.y - QUERY_RADIUS : 0;
+            const uint endX = std::min(center.x + QUERY_RADIUS, MAP_SIZE - 1);
+            const uint endY = std::min(center.y + QUERY_RADIUS, MAP_SIZE - 1);
+            for (uint y = startY; y <= endY; y++)
+                for (uint x = startX; x <= endX; x++)
+                    nSolid += map.tileAt(Coordinate{x, y}).wallMaterial != MATERIAL_ID_AIR;
+        }
+        sink = nSolid;
+    });
+
+    // Neighbour lookups: for every tile, read the four tiles next to it, as autotiling does.
+    const double neighbourMs = fastestRun([&map, &sink] {
+        uint nMatches = 0;
+        for (uint y = 1; y < MAP_SIZE - 1; y++) {
+            for (uint x = 1; x < MAP_SIZE - 1; x++) {
+                const MaterialID wall = map.tileAt(Coordinate{x, y}).wallMaterial;
+                nMatches += (map.tileAt(Coordinate{x + 1, y}).wallMaterial == wall) +
+                            (map.tileAt(Coordinate{x - 1, y}).wallMaterial == wall) +
+                            (map.tileAt(Coordinate{x, y + 1}).wallMaterial == wall) +
+                            (map.tileAt(Coordinate{x, y - 1}).wallMaterial == wall);
+            }
+        }
+        sink = nMatches;
+    });
+
+    printf("TileMap %-10s %ux%u  fill %8.2f ms  area query %8.2f ms  neighbours %8.2f ms\n", layoutName, MAP_SIZE,
+           MAP_SIZE, fillMs, queryMs, neighbourMs);
+}
+
+void benchmarkWorld(const char *layoutName) {
+    World world(WORLD_SIZE, WORLD_SIZE, 100);
+    world.setWorkerCount(1);
+
+    std::mt19937 random(7);
+    std::uniform_int_distribution<uint> position(0, WORLD_SIZE - 1);
+    for (uint i = 0; i < N_ENTITIES; i++)
+        world.addEntity(new BenchEntity, Coordinate{position(random), position(random)});
+
+    const std::vector<Coordinate> centers = queryCenters(WORLD_SIZE);
+    volatile uint sink = 0;
+
+    // Circle queries over the chunk grid.
+    const double circleMs = fastestRun([&world, &centers, &sink] {
+        uint nFound = 0;
+        for (const Coordinate &center : centers)
+            for (auto &entityData : world.entitiesInCircle(center, QUERY_RADIUS))
+                nFound += entityData.id() & 1;
+        sink = nFound;
+    });
+
+    // Nearest neighbour queries over the chunk grid.
+    const double nearestMs = fastestRun([&world, &centers, &sink] {
+        uint nFound = 0;
+        for (const Coordinate &center : centers)
+            nFound += (uint) world.findNearest(center, [](ObjectAndData<Ientity, EID> &) { return true; }, 200,
+                                               8).size();
+        sink = nFound;
+    });
+
+    // Render fill, including the entity overlay. The display is invalidated so that every run loads the
+    //   whole world, instead of only the tiles that changed.
+    DisplayArray displayArray = world.getMap()->generateDisplayArray();
+    const double fillMs = fastestRun([&world, &displayArray] {
+        world.invalidateDisplay();
+        world.loadDisplayArray(displayArray);
+    });
+    delete[] displayArray.displayData;
+
+    printf("World   %-10s %ux%u  circle %8.2f ms  nearest %8.2f ms  fill %8.2f ms\n", layoutName, WORLD_SIZE,
+           WORLD_SIZE, circleMs, nearestMs, fillMs);
+}
+
+int main(int argc, char *argv[]) {
+    benchmarkTileMap<RowMajorLayout>("row-major");
+    benchmarkTileMap<MortonLayout>("morton");
+
+#ifdef WELT_MORTON_LAYOUT
+    benchmarkWorld("morton");
+#else
+    benchmarkWorld("row-major");
+#endif
+
+    return 0;
+}
@@ -0,0 +1,447 @@
+// welt_bench.cpp : Micro and macro benchmarks for World, TileMap, spatial queries, autotiling and snapshots.
+//
+// Usage: welt_bench [--json FILE] [--filter TEXT] [--repeats N] [--quick]
+//   --json     Also write the results to FILE as JSON, to compare between releases.
+//   --filter   Only run the benchmarks whose name contains TEXT.
+//   --repeats  Run each benchmark N times (default 5). The fastest and the mean run are reported.
+//   --quick    Use smaller sizes, for a fast check that everything runs.
+
+#include "../src/world.h"
+#include "../src/Autotiler.h"
+#include "../src/WorldSnapshot.h"
+#include "../examples/01-Wolf_and_Sheep/Sheep.h"
+#include "../examples/01-Wolf_and_Sheep/Wolf.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+const uint DEFAULT_REPEATS = 5;
+const uint N_QUERIES = 2000;
+const uint TICKS_PER_RUN = 10;
+
+// An entity that never does anything, for filling the World.
+class BenchEntity : public Ientity {
+public:
+    std::vector<std::size_t> getEntityTypeHash() override { return std::vector<std::size_t>(); }
+
+    EffectedType tick(Iworld<Ientity, EID, Iitem, IID> *worldPointer, const TileMap *map,
+                      const ObjectAndData<Ientity, EID> &selfReference, uint energy) override {
+        return EffectedType::NONE;
+    }
+
+    EffectedType takeDamage(EID attacker, uint damageAmount, DamageType type) override { return EffectedType::NONE; }
+
+    uint getHealth() override { return 1; }
+
+    uint getObjectType() override { return 1; }
+
+    Material getMaterial() override { return M_ENTITY; }
+
+    DisplayID getDisplayID() override { return DCID_ENTITY_SIMPLE; }
+};
+
+// A named benchmark parameter, such as a size or a radius.
+struct BenchParam {
+    std::string name;
+    double value;
+};
+
+struct BenchResult {
+    std::string name;
+    std::vector<BenchParam> params;
+    double itemsPerRun; // What one run processes, such as ticks or queries.
+    double fastestMs, meanMs;
+};
+
+// Runs benchmarks, keeps their results, and reports them as a table and as JSON.
+class BenchSuite {
+public:
+    BenchSuite(std::string filter, uint repeats) : filter(std::move(filter)), repeats(repeats) {}
+
+    // Returns true if a benchmark with the given name should run.
+    bool isSelected(const std::string &name) const { return name.find(filter) != std::string::npos; }
+
+    template<class Setup, class Run>
+    void run(const std::string &name, const std::vector<BenchParam> &params, double itemsPerRun, Setup &&setup,
+             Run &&function);
+
+    template<class Run>
+    void run(const std::string &name, const std::vector<BenchParam> &params, double itemsPerRun, Run &&function) {
+        this->run(name, params, itemsPerRun, [] {}, std::forward<Run>(function));
+    }
+
+    bool writeJson(const std::string &path) const;
+
+private:
+    std::string filter;
+    uint repeats;
+    std::vector<BenchResult> results;
+};
+
+// Calls setup, untimed, then times function, repeats times over. Prints and keeps the result.
+template<class Setup, class Run>
+void BenchSuite::run(const std::string &name, const std::vector<BenchParam> &params, double itemsPerRun,
+                     Setup &&setup, Run &&function) {
+    if (!this->isSelected(name))
+        return;
+
+    BenchResult result{name, params, itemsPerRun, 0, 0};
+    double totalMs = 0;
+    for (uint i = 0; i < repeats; i++) {
+        setup();
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if ((i == 0) || (ms < result.fastestMs))
+            result.fastestMs = ms;
+        totalMs += ms;
+    }
+    result.meanMs = totalMs / repeats;
+
+    std::string paramText;
+    for (const BenchParam &param : params)
+        paramText += param.name + "=" + std::to_string((long long) param.value) + " ";
+    printf("%-24s %-36s fastest %10.3f ms  mean %10.3f ms  %12.0f items/s\n", name.c_str(), paramText.c_str(),
+           result.fastestMs, result.meanMs, (result.fastestMs > 0) ? itemsPerRun * 1000 / result.fastestMs : 0.0);
+    fflush(stdout);
+
+    results.push_back(result);
+}
+
+// Writes every result to the file at the given path as JSON. Returns true if successful.
+bool BenchSuite::writeJson(const std::string &path) const {
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+
+#ifdef WELT_MORTON_LAYOUT
+    const char *layoutName = "morton";
+#else
+    const char *layoutName = "row-major";
+#endif
+#ifdef NDEBUG
+    const bool isOptimized = true;
+#else
+    const bool isOptimized = false;
+#endif
+
+    fprintf(file, "{\n  \"context\": {\"layout\": \"%s\", \"ndebug\": %s, ", layoutName,
+            isOptimized ? "true" : "false");
+    fprintf(file, "\"hardware_threads\": %u, \"repeats\": %u},\n", std::thread::hardware_concurrency(), repeats);
+    fprintf(file, "  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult &result = results[i];
+        fprintf(file, "    {\"name\": \"%s\", \"params\": {", result.name.c_str());
+        for (size_t j = 0; j < result.params.size(); j++)
+            fprintf(file, "%s\"%s\": %g", (j == 0) ? "" : ", ", result.params[j].name.c_str(), result.params[j].value);
+        fprintf(file, "}, \"items_per_run\": %g, \"fastest_ms\": %.6f, \"mean_ms\": %.6f, ", result.itemsPerRun,
+                result.fastestMs, result.meanMs);
+        fprintf(file, "\"items_per_second\": %.3f}%s\n",
+                (result.fastestMs > 0) ? result.itemsPerRun * 1000 / result.fastestMs : 0.0,
+                (i + 1 < results.size()) ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    return fclose(file) == 0;
+}
+
+// Returns random coordinates inside a square of the given size, the same for every call with the same seed.
+std::vector<Coordinate> randomCoordinates(uint count, uint size, uint seed) {
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<uint> position(0, size - 1);
+
+    std::vector<Coordinate> coordinates;
+    coordinates.reserve(count);
+    for (uint i = 0; i < count; i++)
+        coordinates.push_back(Coordinate{position(random), position(random)});
+
+    return coordinates;
+}
+
+// Sets the floor to grass and the walls to air, like the example does.
+void clearMap(TileMap &map) {
+    for (uint y = 0; y < map.height(); y++) {
+        for (uint x = 0; x < map.width(); x++) {
+            map.setFloorMaterial(Coordinate{x, y}, M_GRASS);
+            map.setWallMaterial(Coordinate{x, y}, M_AIR, 0);
+        }
+    }
+}
+
+// World::tick for the Wolf and Sheep example: the bottom half of the world full of sheep, and one wolf
+//   for every 1000 sheep.
+void benchmarkTick(BenchSuite &suite, const std::vector<uint> &sizes) {
+    if (!suite.isSelected("tick_wolf_sheep"))
+        return;
+
+    for (uint size : sizes) {
+        for (uint isParallel = 0; isParallel < 2; isParallel++) {
+            std::unique_ptr<World> world;
+            suite.run("tick_wolf_sheep", {{"size", (double) size}, {"parallel", (double) isParallel}},
+                      TICKS_PER_RUN, [&] {
+                        world.reset(new World(size, size, 100));
+                        world->setParallelTick(isParallel != 0);
+                        clearMap(*world->getMap());
+                        uint nSheep = 0;
+                        for (uint y = size / 2; y < size; y++) {
+                            for (uint x = 0; x < size; x++) {
+                                world->addEntity(new Sheep, Coordinate{x, y});
+                                nSheep++;
+                            }
+                        }
+                        for (uint i = 0; i <= nSheep / 1000; i++)
+                            world->addEntity(new Wolf, Coordinate{i % size, i / size});
+                    }, [&] {
+                        for (uint i = 0; i < TICKS_PER_RUN; i++)
+                            world->tick();
+                    });
+        }
+    }
+}
+
+// Circle queries at several radii and entity densities, through getObjectsInCircle and through the
+//   allocation-free entitiesInCircle.
+void benchmarkCircleQueries(BenchSuite &suite, uint worldSize) {
+    if (!suite.isSelected("circle_query"))
+        return;
+
+    const double densities[] = {0.01, 0.1, 0.5};
+    const uint radii[] = {4, 16, 64};
+    const std::vector<Coordinate> centers = randomCoordinates(N_QUERIES, worldSize, 42);
+    volatile uint sink = 0;
+
+    for (double density : densities) {
+        World world(worldSize, worldSize, 100);
+        world.setWorkerCount(1);
+        for (const Coordinate &cord : randomCoordinates((uint) (density * worldSize * worldSize), worldSize, 7))
+            world.addEntity(new BenchEntity, cord);
+
+        for (uint radius : radii) {
+            const std::vector<BenchParam> params = {{"density_percent", density * 100}, {"radius", (double) radius}};
+
+            suite.run("circle_query_search", params, N_QUERIES, [&] {
+                uint nFound = 0;
+                for (const Coordinate &center : centers) {
+                    auto found = world.getObjectsInCircle(center, radius, true, false).entitiesFound;
+                    for (; !found->isAtEnd(); found->next())
+                        nFound++;
+                }
+                sink = nFound;
+            });
+
+            suite.run("circle_query_range", params, N_QUERIES, [&] {
+                uint nFound = 0;
+                for (const Coordinate &center : centers) {
+                    for (auto &entityData : world.entitiesInCircle(center, radius))
+                        nFound += entityData.id() & 1;
+                }
+                sink = nFound;
+            });
+        }
+    }
+}
+
+// moveEntity for entities that stay in their chunk, and for entities that cross into the next chunk.
+//   Each entity is moved one tile east and back again.
+void benchmarkMoves(BenchSuite &suite, uint worldSize) {
+    if (!suite.isSelected("move_entity"))
+        return;
+
+    // Chunks are 16 tiles wide. Column 7 moves to column 8 of the same chunk, column 15 to the next chunk.
+    const uint startColumns[] = {7, 15};
+    const char *names[] = {"move_entity_in_chunk", "move_entity_across_chunks"};
+
+    for (uint i = 0; i < 2; i++) {
+        World world(worldSize, worldSize, 100);
+        std::vector<Coordinate> positions;
+        for (uint y = 0; y < worldSize; y += 2) {
+            for (uint x = startColumns[i]; x + 1 < worldSize; x += 16) {
+                world.addEntity(new BenchEntity, Coordinate{x, y});
+                positions.push_back(Coordinate{x, y});
+            }
+        }
+
+        suite.run(names[i], {{"entities", (double) positions.size()}}, positions.size() * 2.0, [&] {
+            for (const Coordinate &position : positions)
+                world.moveEntity(*world.getEntityOnTile(position), Coordinate{position.x + 1, position.y});
+            for (const Coordinate &position : positions) {
+                const Coordinate moved = Coordinate{position.x + 1, position.y};
+                world.moveEntity(*world.getEntityOnTile(moved), position);
+            }
+        });
+    }
+}
+
+// addEntity when spawning many entities into an empty world.
+void benchmarkSpawning(BenchSuite &suite, uint worldSize, const std::vector<uint> &counts) {
+    if (!suite.isSelected("add_entity_bulk"))
+        return;
+
+    for (uint count : counts) {
+        const std::vector<Coordinate> positions = randomCoordinates(count, worldSize, 11);
+        std::unique_ptr<World> world;
+        suite.run("add_entity_bulk", {{"entities", (double) count}, {"size", (double) worldSize}}, count,
+                  [&] { world.reset(new World(worldSize, worldSize, 100)); }, [&] {
+                    for (const Coordinate &position : positions)
+                        world->addEntity(new BenchEntity, position);
+                });
+    }
+}
+
+// Loading DisplayArrays from a TileMap, and from a World with entities on it, in full and through a view.
+void benchmarkDisplay(BenchSuite &suite, const std::vector<uint> &sizes) {
+    if (!suite.isSelected("load_display"))
+        return;
+
+    for (uint size : sizes) {
+        World world(size, size, 100);
+        world.setWorkerCount(1);
+        TileMap &map = *world.getMap();
+        for (uint y = 0; y < size; y++)
+            for (uint x = 0; x < size; x++)
+                map.setWallMaterial(Coordinate{x, y}, ((x ^ y) & 7) ? M_AIR : M_STONE, 0);
+        for (const Coordinate &cord : randomCoordinates(size * size / 20, size, 5))
+            world.addEntity(new BenchEntity, cord);
+
+        DisplayArray displayArray;
+        suite.run("load_display_tilemap", {{"size", (double) size}}, (double) size * size,
+                  [&] { map.loadDisplayArray(displayArray); });
+
+        suite.run("load_display_world", {{"size", (double) size}}, (double) size * size, [&] {
+            world.invalidateDisplay();
+            world.loadDisplayArray(displayArray);
+        });
+
+        const ViewRect view{size / 4, size / 4, std::min(size / 2, 100u), std::min(size / 2, 100u)};
+        suite.run("load_display_world_view", {{"size", (double) size}, {"view", (double) view.width}},
+                  (double) view.width * view.height, [&] { world.loadDisplayArray(displayArray, view); });
+        delete[] displayArray.displayData;
+    }
+}
+
+// Autotiling a DisplayArray of walls and floors, element by element and as one pass.
+void benchmarkAutotiling(BenchSuite &suite, const std::vector<uint> &sizes) {
+    if (!suite.isSelected("autotile"))
+        return;
+
+    // Give every displayID its own sprites, so every lookup matters.
+    const uint nSI = 16;
+    flat::FlatVector<SpriteInteraction> SI_list;
+    SI_list.setCapacity(nSI);
+    for (uint i = 0; i < nSI; i++) {
+        const displayID base = i * 16;
+        SI_list.set(i, SpriteInteraction{"", base, base + 1, base + 2, base + 3, base + 4, base + 5, base + 6,
+                                         base + 7, base + 8, base + 9, base + 10, base + 11, base + 12, base + 13,
+                                         base + 14, base + 15});
+    }
+    Autotiler autotiler;
+    autotiler.build(SI_list, nSI);
+
+    for (uint size : sizes) {
+        DisplayArray displayArray;
+        resizeDisplayArray(displayArray, size, size);
+        std::mt19937 random(3);
+        for (uint i = 0; i < size * size; i++) {
+            displayArray.displayData[i].BackgroundInfo = DCID_GROUND_OUTSIDE;
+            displayArray.displayData[i].ForegroundInfo = (random() % 4) ? DCID_AIR : DCID_SLDWALL_CONNECT;
+        }
+
+        std::vector<ResolvedSprite> resolved;
+        volatile uint sink = 0;
+        suite.run("autotile_per_element", {{"size", (double) size}}, (double) size * size, [&] {
+            uint checksum = 0;
+            for (uint row = 0; row < size; row++) {
+                for (uint col = 0; col < size; col++) {
+                    const DisplayArrayElement &element = displayArray.displayData[col + (size * row)];
+                    checksum += autotiler.lookup(element.BackgroundInfo, Autotiler::getNeighbourMask(
+                            col, row, displayArray, &DisplayArrayElement::BackgroundInfo));
+                    checksum += autotiler.lookup(element.ForegroundInfo, Autotiler::getNeighbourMask(
+                            col, row, displayArray, &DisplayArrayElement::ForegroundInfo));
+                }
+            }
+            sink = checksum;
+        });
+
+        suite.run("autotile_pass", {{"size", (double) size}}, (double) size * size,
+                  [&] { autotiler.resolveSprites(displayArray, resolved); });
+        delete[] displayArray.displayData;
+    }
+}
+
+// Saving a World with an entity in every 8 by 8 block of tiles to a snapshot file, and loading it back.
+//   Loading borrows the tile pages from the mapped file, so its time is mostly the World's own setup and the entities.
+void benchmarkSnapshots(BenchSuite &suite, const std::vector<uint> &sizes) {
+    if (!suite.isSelected("snapshot"))
+        return;
+
+    const std::string path = "welt_bench.snapshot";
+    SnapshotRegistry registry;
+    registry.registerEntity<BenchEntity>("BenchEntity");
+
+    for (uint size : sizes) {
+        World world(size, size, 100, true);
+        clearMap(*world.getMap());
+        for (uint y = 0; y < size; y += 8) {
+            for (uint x = 0; x < size; x += 8)
+                world.addEntity(new BenchEntity, Coordinate{x, y});
+        }
+
+        bool isSaved = true;
+        suite.run("snapshot_save", {{"size", (double) size}}, (double) size * size,
+                  [&] { isSaved = WorldSnapshot::save(world, path, registry) && isSaved; });
+        if (!isSaved) {
+            printf("!Could not write \"%s\"!\n", path.c_str());
+            return;
+        }
+
+        std::unique_ptr<World> loaded;
+        suite.run("snapshot_load", {{"size", (double) size}}, (double) size * size, [&] { loaded.reset(); },
+                  [&] { loaded = WorldSnapshot::load(path, registry); });
+    }
+
+    remove(path.c_str());
+}
+
+int main(int argc, char *argv[]) {
+    std::string jsonPath, filter;
+    uint repeats = DEFAULT_REPEATS;
+    bool isQuick = false;
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "--json") == 0) && (i + 1 < argc)) {
+            jsonPath = argv[++i];
+        } else if ((strcmp(argv[i], "--filter") == 0) && (i + 1 < argc)) {
+            filter = argv[++i];
+        } else if ((strcmp(argv[i], "--repeats") == 0) && (i + 1 < argc)) {
+            repeats = std::max(1u, (uint) strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--quick") == 0) {
+            isQuick = true;
+        } else {
+            printf("Unknown argument \"%s\"\n", argv[i]);
+            printf("Usage: welt_bench [--json FILE] [--filter TEXT] [--repeats N] [--quick]\n");
+            return 1;
+        }
+    }
+
+    BenchSuite suite(filter, repeats);
+    benchmarkTick(suite, isQuick ? std::vector<uint>{64} : std::vector<uint>{64, 128, 256});
+    benchmarkCircleQueries(suite, isQuick ? 128 : 512);
+    benchmarkMoves(suite, isQuick ? 128 : 1024);
+    benchmarkSpawning(suite, isQuick ? 256 : 1024,
+                      isQuick ? std::vector<uint>{1000} : std::vector<uint>{10000, 100000});
+    benchmarkDisplay(suite, isQuick ? std::vector<uint>{128} : std::vector<uint>{256, 1024, 2048});
+    benchmarkAutotiling(suite, isQuick ? std::vector<uint>{100} : std::vector<uint>{100, 300, 1000});
+    benchmarkSnapshots(suite, isQuick ? std::vector<uint>{256} : std::vector<uint>{256, 1024, 4096});
+
+    if (!jsonPath.empty() && !suite.writeJson(jsonPath)) {
+        printf("!Could not write \"%s\"!\n", jsonPath.c_str());
+        return 1;
+    }
+
+    return 0;
+}
@@ -89,6 +89,10 @@ SDL_Color LTexture::getModColor() const {
         return SDL_Color{0xFF, 0xFF, 0xFF};
 }
 
+// Returns the SDL texture, or nullptr if no image is loaded.
+SDL_Texture *LTexture::getTexture() const {
+    return mTexture;
+}
 
 bool LTexture::setRenderer(SDL_Renderer *renderer) {
     if (renderer == nullptr) {
@@ -27,6 +27,8 @@ public:
 
     SDL_Color getModColor() const;
 
+    SDL_Texture *getTexture() const;
+
     bool setRenderer(SDL_Renderer *renderer);
 
     void setModColor(const SDL_Color &color);
@@ -0,0 +1,162 @@
+#include "PixelSpriteSet.h"
+
+#include <cstring>
+#include <algorithm>
+
+PixelSpriteSet::PixelSpriteSet() {
+    nTiles = 0;
+    fontWidth = 0;
+    fontHeight = 0;
+}
+
+// Loads the image at the given path and splits it into sprites of the given size. Returns the number of
+//   tiles loaded, or zero if the image could not be loaded or is not a whole number of tiles.
+uint PixelSpriteSet::loadFromFile(const std::string &path, const uint tileWidth, const uint tileHeight) {
+    atlas.clear();
+    nTiles = 0;
+
+    if ((tileWidth == 0) || (tileHeight == 0))
+        return 0;
+
+    // Load the image and convert it to RGBA, so its bytes can be copied as they are.
+    SDL_Surface *loadedSurface = IMG_Load(path.c_str());
+    if (loadedSurface == nullptr) {
+        printf("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
+        return 0;
+    }
+    SDL_Surface *surface = SDL_ConvertSurfaceFormat(loadedSurface, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loadedSurface);
+    if (surface == nullptr) {
+        printf("Unable to convert image %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+        return 0;
+    }
+
+    // If the image is not formatted correctly, free and return zero.
+    const uint imageWidth = (uint) surface->w, imageHeight = (uint) surface->h;
+    if (((imageHeight % tileHeight) != 0) || ((imageWidth % tileWidth) != 0)) {
+        printf("Bad dem. Source height %% tile Height = %u Source width %% tile width = %u\n",
+               imageHeight % tileHeight, imageWidth % tileWidth);
+        SDL_FreeSurface(surface);
+        return 0;
+    }
+
+    // Copy each sprite into the atlas, so the rows of a sprite are next to each other in memory.
+    const uint nTilesPerRow = imageWidth / tileWidth;
+    const uint nTilesLoaded = nTilesPerRow * (imageHeight / tileHeight);
+    const size_t rowBytes = (size_t) tileWidth * 4;
+    atlas.resize((size_t) nTilesLoaded * tileHeight * rowBytes);
+
+    SDL_LockSurface(surface);
+    const auto *imagePixels = (const uint8_t *) surface->pixels;
+    for (uint tile = 0; tile < nTilesLoaded; tile++) {
+        const uint xPos = (tile % nTilesPerRow) * tileWidth, yPos = (tile / nTilesPerRow) * tileHeight;
+        for (uint row = 0; row < tileHeight; row++) {
+            const uint8_t *source = imagePixels + ((size_t) (yPos + row) * surface->pitch) + ((size_t) xPos * 4);
+            uint8_t *destination = atlas.data() + (((size_t) tile * tileHeight) + row) * rowBytes;
+            std::memcpy(destination, source, rowBytes);
+        }
+    }
+    SDL_UnlockSurface(surface);
+    SDL_FreeSurface(surface);
+
+    // Black is the color key, so make black pixels transparent.
+    for (size_t i = 0; i < atlas.size(); i += 4) {
+        if ((atlas[i] == 0) && (atlas[i + 1] == 0) && (atlas[i + 2] == 0))
+            atlas[i + 3] = 0;
+    }
+
+    fontWidth = tileWidth;
+    fontHeight = tileHeight;
+    nTiles = nTilesLoaded;
+
+    return nTiles;
+}
+
+// Draws the specified sprite into the frame at the given point, tinted by the given color like a texture
+//   color mod. Transparent pixels leave the frame as it was, and parts outside the frame are skipped.
+//   If the specified sprite is not loaded, the function returns false.
+bool PixelSpriteSet::blit(PixelFrame &frame, int x, int y, displayID valueToDisplay, const SDL_Color &color) const {
+    if (valueToDisplay >= nTiles)
+        return false;
+
+    // Clip the sprite to the frame.
+    const int firstColumn = std::max(0, -x), endColumn = std::min((int) fontWidth, (int) frame.width - x);
+    const int firstRow = std::max(0, -y), endRow = std::min((int) fontHeight, (int) frame.height - y);
+    if ((firstColumn >= endColumn) || (firstRow >= endRow))
+        return true;
+
+    const uint8_t tint[4] = {color.r, color.g, color.b, 0xFF};
+    const uint8_t *sprite = atlas.data() + ((size_t) valueToDisplay * fontHeight * fontWidth * 4);
+
+    // Each row is tinted a byte at a time and then merged a pixel at a time. Both loops are branch-free
+    //   so the compiler can vectorize them.
+    uint8_t tinted[4 * 64];
+    for (int row = firstRow; row < endRow; row++) {
+        const uint8_t *source = sprite + (((size_t) row * fontWidth) + firstColumn) * 4;
+        uint32_t *destination = frame.pixels.data() + ((size_t) (y + row) * frame.width) + (x + firstColumn);
+
+        for (int column = firstColumn; column < endColumn; column += 64) {
+            const int nPixels = std::min(64, endColumn - column);
+            for (int i = 0; i < nPixels * 4; i++)
+                tinted[i] = (uint8_t) ((source[i] * tint[i & 3] + 0xFF) >> 8);
+
+            for (int i = 0; i < nPixels; i++) {
+                uint32_t pixel;
+                std::memcpy(&pixel, tinted + (i * 4), 4);
+                destination[i] = (source[(i * 4) + 3] != 0) ? pixel : destination[i];
+            }
+
+            source += 64 * 4;
+            destination += 64;
+        }
+    }
+
+    return true;
+}
+
+// Gives the frame the given dimensions. The contents of the frame are not kept.
+void resizePixelFrame(PixelFrame &frame, uint width, uint height) {
+    frame.width = width;
+    frame.height = height;
+    frame.pixels.resize((size_t) width * height);
+}
+
+// Sets every pixel of the frame to the given color.
+void clearPixelFrame(PixelFrame &frame, const SDL_Color &color) {
+    const uint8_t bytes[4] = {color.r, color.g, color.b, color.a};
+    uint32_t pixel;
+    std::memcpy(&pixel, bytes, 4);
+    std::fill(frame.pixels.begin(), frame.pixels.end(), pixel);
+}
+
+// Copies the frame into a streaming texture of the same size and SDL_PIXELFORMAT_RGBA32 format.
+//   Returns true if successful.
+bool copyPixelFrameToTexture(const PixelFrame &frame, SDL_Texture *texture) {
+    void *texturePixels;
+    int pitch;
+    if (!texture || (SDL_LockTexture(texture, nullptr, &texturePixels, &pitch) != 0))
+        return false;
+
+    const size_t rowBytes = (size_t) frame.width * 4;
+    for (uint row = 0; row < frame.height; row++) {
+        std::memcpy((uint8_t *) texturePixels + ((size_t) row * pitch),
+                    frame.pixels.data() + ((size_t) row * frame.width), rowBytes);
+    }
+
+    SDL_UnlockTexture(texture);
+    return true;
+}
+
+// Saves the frame as a BMP file at the given path. Needs no window or renderer. Returns true if successful.
+bool savePixelFrame(const PixelFrame &frame, const std::string &path) {
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormatFrom((void *) frame.pixels.data(), (int) frame.width,
+                                                              (int) frame.height, 32, (int) (frame.width * 4),
+                                                              SDL_PIXELFORMAT_RGBA32);
+    if (surface == nullptr)
+        return false;
+
+    const bool wasSaveSuccessful = SDL_SaveBMP(surface, path.c_str()) == 0;
+    SDL_FreeSurface(surface);
+
+    return wasSaveSuccessful;
+}
@@ -0,0 +1,53 @@
+#ifndef WELT_PIXELSPRITESET_H
+#define WELT_PIXELSPRITESET_H
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "../../src/universal.h"
+#include "../../src/DisplayIDdef.h"
+
+// A frame of pixels in memory, four bytes per pixel in the order R, G, B, A (SDL_PIXELFORMAT_RGBA32).
+struct PixelFrame {
+    uint width, height;
+    std::vector<uint32_t> pixels;
+
+    PixelFrame() : width(0), height(0) {}
+};
+
+// A SpriteSet kept in memory instead of in a texture, for tilesets like pixel_1x1.png and pixel_3x3.png
+//   where each sprite is a small tinted block. Sprites are drawn by copying their rows straight into a
+//   PixelFrame, which can then be uploaded to an SDL streaming texture or saved without a window.
+// Like SpriteSet, black pixels in the image are treated as transparent.
+class PixelSpriteSet {
+public:
+    PixelSpriteSet();
+
+    // Loads image at specified path. Returns the number of tiles loaded. No renderer is needed.
+    uint loadFromFile(const std::string &path, uint tileWidth, uint tileHeight);
+
+    bool blit(PixelFrame &frame, int x, int y, displayID valueToDisplay, const SDL_Color &color) const;
+
+    uint getFontWidth() const { return fontWidth; }
+
+    uint getFontHeight() const { return fontHeight; }
+
+    uint getNTiles() const { return nTiles; }
+
+private:
+    std::vector<uint8_t> atlas; // Every sprite's pixels, one sprite after another, row-major.
+    uint fontWidth, fontHeight, nTiles;
+};
+
+void resizePixelFrame(PixelFrame &frame, uint width, uint height);
+
+void clearPixelFrame(PixelFrame &frame, const SDL_Color &color);
+
+bool copyPixelFrameToTexture(const PixelFrame &frame, SDL_Texture *texture);
+
+bool savePixelFrame(const PixelFrame &frame, const std::string &path);
+
+
+#endif //WELT_PIXELSPRITESET_H
@@ -13,7 +13,7 @@ std::vector<std::size_t> Sheep::getEntityTypeHash() {
 }
 
 EffectedType
-Sheep::tick(Iworld<Ientity, EID, Iitem, IID> *worldPointer, TileMap *map,
+Sheep::tick(Iworld<Ientity, EID, Iitem, IID> *worldPointer, const TileMap *map,
             const ObjectAndData<Ientity, EID> &selfReference, uint energy) {
     if (selfHealth == 0)
         return EffectedType::DELETED;
@@ -25,44 +25,35 @@ Sheep::tick(Iworld<Ientity, EID, Iitem, IID> *worldPointer, TileMap *map,
         selfEnergy = maxEnergy;
 
     while (selfEnergy >= energyNeededForMove) {
-        auto tmpResults = worldPointer->getObjectsInCircle(selfReference.coordinate(), 1, true, false);
-
-
-        uint count = 0;
-        while (!tmpResults.entitiesFound->isAtEnd()) {
-            ++count;
-            tmpResults.entitiesFound->next();
+        // Count this sheep and the entities on the four tiles next to it.
+        const Coordinate selfPos = selfReference.coordinate();
+        const Coordinate neighbours[4] = {Coordinate{selfPos.x + 1, selfPos.y}, Coordinate{selfPos.x - 1, selfPos.y},
+                                          Coordinate{selfPos.x, selfPos.y + 1}, Coordinate{selfPos.x, selfPos.y - 1}};
+        uint count = 1;
+        for (const auto &neighbour : neighbours) {
+            if (worldPointer->getEntityOnTile(neighbour))
+                ++count;
         }
 
 
-        if (count >= 5)
+        // If the sheep is boxed in, there is nothing to do until one of its neighbours moves.
+        if (count >= 5) {
+            worldPointer->sleepUntilNearbyChange(selfReference);
             return EffectedType::NONE;
+        }
 
 
-        SearchResult<Ientity, EID, Iitem, IID> searchResults = worldPointer->getObjectsInCircle(
-                selfReference.coordinate(), 100, true, false);
-
-        ObjectAndData<Ientity, EID> enemyPtr(nullptr, nullptr, true, 0, Coordinate());
-        uint enemyDistance = 0;
-
-        for (; !searchResults.entitiesFound->isAtEnd(); searchResults.entitiesFound->next()) {
-            if ((searchResults.entitiesFound->id() != selfReference.id()) &&
-                (searchResults.entitiesFound->object().getObjectType() == 2)) {
-                uint entDistance = (uint) ceil(
-                        distance(selfReference.coordinate(), searchResults.entitiesFound->position()));
-                if (enemyPtr.isPlaceholder()) {
-                    enemyPtr = searchResults.entitiesFound->ObjectAndDataCopy();
-                    enemyDistance = entDistance;
-                } else if (entDistance < enemyDistance) {
-                    enemyPtr = searchResults.entitiesFound->ObjectAndDataCopy();
-                    enemyDistance = entDistance;
-                }
-            }
-        }
+        // Find the closest wolf.
+        const vector<ObjectAndData<Ientity, EID>> nearestEnemy = worldPointer->findNearestOfType(
+                selfReference.coordinate(), 2, [&selfReference](ObjectAndData<Ientity, EID> &entityData) {
+                    return entityData.id() != selfReference.id();
+                }, 100);
 
-        if (enemyPtr.isPlaceholder())
+        if (nearestEnemy.empty())
             break;
 
+        const ObjectAndData<Ientity, EID> &enemyPtr = nearestEnemy.front();
+
         Coordinate delta = Coordinate{1, 1};
         if (enemyPtr.coordinate().x > selfReference.coordinate().x)
             delta.x = 0;
@@ -76,19 +67,11 @@ Sheep::tick(Iworld<Ientity, EID, Iitem, IID> *worldPointer, TileMap *map,
 
         Coordinate nextPos = Coordinate{(selfReference.coordinate().x + delta.x) - 1,
                                         (selfReference.coordinate().y + delta.y) - 1};
-        Tile *nextTile = map->at(nextPos);
-        SearchResult<Ientity, EID, Iitem, IID> nextTileSearch = worldPointer->getObjectsOnTile(nextPos, true, false);
-        if (nextTileSearch.entitiesFound) {
-            bool isNextTileClear = nextTileSearch.entitiesFound->isAtEnd();
-            if ((!isNextTileClear) || (!nextTile) || (nextTile->wallMaterial.materialType != MaterialType::GAS))
-                return EffectedType::NONE;
-
-            if (worldPointer->moveEntity(selfReference, nextPos)) {
-                wasMoved = true;
-                selfEnergy -= energyNeededForMove;
-            }
-        } else
+        if (worldPointer->tryMove(selfReference, nextPos, PASS_GAS) != MoveResult::MOVED)
             break;
+
+        wasMoved = true;
+        selfEnergy -= energyNeededForMove;
     }
 
     if (wasMoved)
@@ -124,6 +107,17 @@ DisplayID Sheep::getDisplayID() {
     return entityDisplay;
 }
 
+void Sheep::saveState(ByteWriter &writer) {
+    writer.writeU32(selfHealth);
+    writer.writeU32(selfEnergy);
+}
+
+bool Sheep::loadState(ByteReader &reader) {
+    selfHealth = reader.readU32();
+    selfEnergy = reader.readU32();
+    return reader.isValid();
+}
+
 std::vector<std::size_t> Sheep::sheepHash() {
     return std::vector<std::size_t>(typeid(this).hash_code());
 }
@@ -0,0 +1,84 @@
+#include "SpriteBatch.h"
+
+SpriteBatch::SpriteBatch(const SpriteSet &spriteSet) : spriteSet(spriteSet) {
+}
+
+// Removes every sprite from the batch. Memory is kept for the next frame.
+void SpriteBatch::clear() {
+    quads.clear();
+}
+
+// Adds the specified sprite to the batch, to be drawn at the given point in the given color.
+//   Sprites are drawn in the order they are added. If the sprite is not loaded, the function returns false.
+bool SpriteBatch::add(int x, int y, displayID valueToDisplay, const SDL_Color &color) {
+    Quad quad;
+    if (!spriteSet.getSpriteRect(valueToDisplay, quad.source))
+        return false;
+
+    quad.destination = SDL_Rect{x, y, quad.source.w, quad.source.h};
+
+    // Colors only tint the sprite, like a color mod, so the alpha of the sprite is kept.
+    quad.color = SDL_Color{color.r, color.g, color.b, 0xFF};
+    quads.push_back(quad);
+
+    return true;
+}
+
+// Draws every sprite in the batch. The texture's color mod is ignored while drawing. Returns true if successful.
+bool SpriteBatch::draw(SDL_Renderer *renderer) {
+    const LTexture *bitmap = spriteSet.getTexture();
+    if (!bitmap || !bitmap->getTexture())
+        return false;
+    if (quads.empty())
+        return true;
+
+    // The color of each quad is multiplied by the texture's color mod, so make it white while drawing.
+    SDL_Texture *texture = bitmap->getTexture();
+    const SDL_Color oldColorMod = bitmap->getModColor();
+    SDL_SetTextureColorMod(texture, 0xFF, 0xFF, 0xFF);
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    // Texture coordinates are given as fractions of the texture's size.
+    const float textureWidth = (float) bitmap->getWidth();
+    const float textureHeight = (float) bitmap->getHeight();
+
+    // Build four vertices per quad. The indices describe two triangles per quad and only depend on the
+    //   number of quads, so they are only extended when the batch grows.
+    vertices.resize(quads.size() * 4);
+    for (size_t i = 0; i < quads.size(); i++) {
+        const Quad &quad = quads[i];
+        const float left = (float) quad.destination.x, right = (float) (quad.destination.x + quad.destination.w);
+        const float top = (float) quad.destination.y, bottom = (float) (quad.destination.y + quad.destination.h);
+        const float u0 = (float) quad.source.x / textureWidth;
+        const float u1 = (float) (quad.source.x + quad.source.w) / textureWidth;
+        const float v0 = (float) quad.source.y / textureHeight;
+        const float v1 = (float) (quad.source.y + quad.source.h) / textureHeight;
+
+        SDL_Vertex *quadVertices = &vertices[i * 4];
+        quadVertices[0] = SDL_Vertex{SDL_FPoint{left, top}, quad.color, SDL_FPoint{u0, v0}};
+        quadVertices[1] = SDL_Vertex{SDL_FPoint{right, top}, quad.color, SDL_FPoint{u1, v0}};
+        quadVertices[2] = SDL_Vertex{SDL_FPoint{left, bottom}, quad.color, SDL_FPoint{u0, v1}};
+        quadVertices[3] = SDL_Vertex{SDL_FPoint{right, bottom}, quad.color, SDL_FPoint{u1, v1}};
+    }
+
+    for (size_t quad = indices.size() / 6; quad < quads.size(); quad++) {
+        const int first = (int) (quad * 4);
+        const int quadIndices[6] = {first, first + 1, first + 2, first + 2, first + 1, first + 3};
+        indices.insert(indices.end(), quadIndices, quadIndices + 6);
+    }
+
+    const bool wasDrawSuccessful = SDL_RenderGeometry(renderer, texture, vertices.data(), (int) vertices.size(),
+                                                      indices.data(), (int) (quads.size() * 6)) == 0;
+#else
+    bool wasDrawSuccessful = true;
+    for (const Quad &quad : quads) {
+        SDL_SetTextureColorMod(texture, quad.color.r, quad.color.g, quad.color.b);
+        if (SDL_RenderCopy(renderer, texture, &quad.source, &quad.destination) != 0)
+            wasDrawSuccessful = false;
+    }
+#endif
+
+    SDL_SetTextureColorMod(texture, oldColorMod.r, oldColorMod.g, oldColorMod.b);
+
+    return wasDrawSuccessful;
+}
@@ -0,0 +1,41 @@
+#ifndef WELT_SPRITEBATCH_H
+#define WELT_SPRITEBATCH_H
+
+#include <SDL.h>
+#include <vector>
+#include "SpriteSet.h"
+#include "../../src/DisplayIDdef.h"
+
+// Collects sprites from one SpriteSet as textured quads, each with its own color, and draws them all
+//   with a single SDL_RenderGeometry call. This replaces one color mod and one render copy per sprite.
+//   SDL_RenderGeometry needs SDL 2.0.18 or newer, and is supported by every renderer, including the
+//   software renderer. With older versions of SDL, draw falls back to rendering one quad at a time.
+class SpriteBatch {
+public:
+    explicit SpriteBatch(const SpriteSet &spriteSet);
+
+    void clear();
+
+    bool add(int x, int y, displayID valueToDisplay, const SDL_Color &color);
+
+    bool draw(SDL_Renderer *renderer);
+
+    // Returns the number of sprites added since the last clear.
+    uint size() const { return (uint) quads.size(); }
+
+private:
+    struct Quad {
+        SDL_Rect source, destination;
+        SDL_Color color;
+    };
+
+    const SpriteSet &spriteSet;
+    std::vector<Quad> quads;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+#endif
+};
+
+
+#endif //WELT_SPRITEBATCH_H
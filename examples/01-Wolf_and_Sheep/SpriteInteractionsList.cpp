@@ -158,12 +158,14 @@ bool SpriteInteractionsList::loadSpriteInteractionsFromFile(const std::string &f
 
         // When done loading the file, print how many SIs were loaded and return true.
         printf("   Loaded %u sprite interactions.\n", nLoadedSI);
+        autotiler.build(SI_list, maxSI_number);
 
         return true;
     } else {
 
         // If the file could not be loaded, notify the user and return false.
         printf("   * Could not open the file \"%s\"\n", path.c_str());
+        autotiler.build(SI_list, maxSI_number);
         return false;
     }
 }
@@ -179,53 +181,8 @@ uint SpriteInteractionsList::getBackgroundTileFromDisplayArray(uint col, uint ro
     if ((col >= dis.width) || (row >= dis.height))
         return 0;
 
-    displayID result = SI_list.get(dis.displayData[col + (dis.width * row)].BackgroundInfo).dDefault;
-
-    bool N, S, E, W;
-    N = (row != 0) && (dis.displayData[col + (dis.width * row)].BackgroundInfo ==
-                       dis.displayData[col + (dis.width * (row - 1))].BackgroundInfo);
-
-    S = (col != (dis.width) - 1) && (dis.displayData[col + (dis.width * row)].BackgroundInfo ==
-                                     dis.displayData[(col + 1) + (dis.width * row)].BackgroundInfo);
-
-    W = (col != 0) && (dis.displayData[col + (dis.width * row)].BackgroundInfo ==
-                       dis.displayData[(col - 1) + (dis.width * row)].BackgroundInfo);
-
-    E = (col != (dis.width) - 1) && (dis.displayData[col + (dis.width * row)].BackgroundInfo ==
-                                     dis.displayData[(col + 1) + (dis.width * row)].BackgroundInfo);
-
-    if (!N && !S && !E && W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].BackgroundInfo).W;
-    if (!N && !S && E && !W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].BackgroundInfo).E;
-    if (!N && !S && E && W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].BackgroundInfo).EW;
-    if (!N && S && !E && !W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].BackgroundInfo).S;
-    if (!N && S && !E && W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].BackgroundInfo).SW;
-    if (!N && S && E && !W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].BackgroundInfo).SE;
-    if (!N && S && E && W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].BackgroundInfo).SEW;
-    if (N && !S && !E && !W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].BackgroundInfo).N;
-    if (N && !S && !E && W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].BackgroundInfo).NW;
-    if (N && !S && E && !W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].BackgroundInfo).NE;
-    if (N && !S && E && W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].BackgroundInfo).NEW;
-    if (N && S && !E && !W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].BackgroundInfo).NS;
-    if (N && S && !E && W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].BackgroundInfo).NSW;
-    if (N && S && E && !W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].BackgroundInfo).NSE;
-    if (N && S && E && W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].BackgroundInfo).NSEW;
-
-    return result;
+    return autotiler.lookup(dis.displayData[col + (dis.width * row)].BackgroundInfo,
+                            Autotiler::getNeighbourMask(col, row, dis, &DisplayArrayElement::BackgroundInfo));
 }
 
 // When given a DisplayArray and a coordinate, this function will
@@ -234,51 +191,13 @@ uint SpriteInteractionsList::getForegroundTileFromDisplayArray(uint col, uint ro
     if ((col >= dis.width) || (row >= dis.height))
         return 0;
 
-    displayID result = SI_list.get(dis.displayData[col + (dis.width * row)].ForegroundInfo).dDefault;
-
-    bool N, S, E, W;
-    N = (row != 0) && (dis.displayData[col + (dis.width * row)].ForegroundInfo ==
-                       dis.displayData[col + (dis.width * (row - 1))].ForegroundInfo);
-
-    S = (row != (dis.height - 1)) && (dis.displayData[col + (dis.width * row)].ForegroundInfo ==
-                                      dis.displayData[col + (dis.width * (row + 1))].ForegroundInfo);
-
-    W = (col != 0) && (dis.displayData[col + (dis.width * row)].ForegroundInfo ==
-                       dis.displayData[(col - 1) + (dis.width * row)].ForegroundInfo);
-
-    E = (col != (dis.width) - 1) && (dis.displayData[col + (dis.width * row)].ForegroundInfo ==
-                                     dis.displayData[(col + 1) + (dis.width * row)].ForegroundInfo);
-
-    if (!N && !S && !E && W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].ForegroundInfo).W;
-    if (!N && !S && E && !W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].ForegroundInfo).E;
-    if (!N && !S && E && W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].ForegroundInfo).EW;
-    if (!N && S && !E && !W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].ForegroundInfo).S;
-    if (!N && S && !E && W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].ForegroundInfo).SW;
-    if (!N && S && E && !W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].ForegroundInfo).SE;
-    if (!N && S && E && W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].ForegroundInfo).SEW;
-    if (N && !S && !E && !W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].ForegroundInfo).N;
-    if (N && !S && !E && W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].ForegroundInfo).NW;
-    if (N && !S && E && !W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].ForegroundInfo).NE;
-    if (N && !S && E && W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].ForegroundInfo).NEW;
-    if (N && S && !E && !W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].ForegroundInfo).NS;
-    if (N && S && !E && W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].ForegroundInfo).NSW;
-    if (N && S && E && !W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].ForegroundInfo).NSE;
-    if (N && S && E && W)
-        result = SI_list.get(dis.displayData[col + (dis.width * row)].ForegroundInfo).NSEW;
+    return autotiler.lookup(dis.displayData[col + (dis.width * row)].ForegroundInfo,
+                            Autotiler::getNeighbourMask(col, row, dis, &DisplayArrayElement::ForegroundInfo));
+}
 
-    return result;
-}
\ No newline at end of file
+// Determines the background and foreground sprites of every element of the DisplayArray at once, and
+//   writes them to resolved, which is resized to match. Gives the same sprites as calling
+//   getBackgroundTileFromDisplayArray and getForegroundTileFromDisplayArray for every element.
+void SpriteInteractionsList::resolveSprites(const DisplayArray &dis, std::vector<ResolvedSprite> &resolved) const {
+    autotiler.resolveSprites(dis, resolved);
+}
@@ -5,12 +5,13 @@
 #include <cctype>
 #include <fstream>
 #include <algorithm>
+#include <vector>
 #include "../../src/universal.h"
 #include "resource.h"
 #include "../../src/DisplayIDdef.h"
+#include "../../src/Autotiler.h"
 
-// Stores mutable SpriteInteractions for easy use.
-
+// Stores mutable SpriteInteractions for easy use. Sprites are picked by an Autotiler built from the list.
 class SpriteInteractionsList {
 public:
     SpriteInteractionsList() = default;
@@ -24,9 +25,12 @@ public:
 
     uint getForegroundTileFromDisplayArray(uint col, uint row, DisplayArray &dis) const;
 
+    void resolveSprites(const DisplayArray &dis, std::vector<ResolvedSprite> &resolved) const;
+
 private:
 
     flat::FlatVector<SpriteInteraction> SI_list;
+    Autotiler autotiler;
 };
 
 
@@ -53,22 +53,10 @@ void SpriteSet::free() {
 
 // Renders the specified sprite. If the specified sprite is not loaded, the function returns false.
 bool SpriteSet::render(unsigned int x, unsigned int y, displayID valueToDisplay) const {
-    // If the SpriteSet is not loaded, return false.
-    if ((mBitmap == nullptr) || (valueToDisplay >= nTiles))
-        return false;
-
-    // Calculate the specified tiles position in the SpriteSet.
-    unsigned int xPos, yPos, nTilesPerRow;
-    nTilesPerRow = mBitmap->getWidth() / fontWidth;
-    xPos = (valueToDisplay % nTilesPerRow) * fontWidth;
-    yPos = (valueToDisplay / nTilesPerRow) * fontHeight;
-
-    // The portion of the SpriteSet image to render.
+    // The portion of the SpriteSet image to render. If the sprite is not loaded, return false.
     SDL_Rect mask;
-    mask.x = (int) xPos;
-    mask.y = (int) yPos;
-    mask.h = fontHeight;
-    mask.w = fontWidth;
+    if (!this->getSpriteRect(valueToDisplay, mask))
+        return false;
 
     // The portion of the renderer to write to.
     SDL_Rect limit;
@@ -122,3 +110,25 @@ void SpriteSet::setColor(const SDL_Color &color) {
 uint SpriteSet::getNTiles() const {
     return nTiles;
 }
+
+// Sets spriteRect to the portion of the SpriteSet image that holds the specified sprite.
+//   If the specified sprite is not loaded, the function returns false.
+bool SpriteSet::getSpriteRect(displayID valueToDisplay, SDL_Rect &spriteRect) const {
+    // If the SpriteSet is not loaded, return false.
+    if ((mBitmap == nullptr) || (valueToDisplay >= nTiles))
+        return false;
+
+    // Calculate the specified tiles position in the SpriteSet.
+    const uint nTilesPerRow = mBitmap->getWidth() / fontWidth;
+    spriteRect.x = (int) ((valueToDisplay % nTilesPerRow) * fontWidth);
+    spriteRect.y = (int) ((valueToDisplay / nTilesPerRow) * fontHeight);
+    spriteRect.w = (int) fontWidth;
+    spriteRect.h = (int) fontHeight;
+
+    return true;
+}
+
+// Returns the texture holding the SpriteSet image, or nullptr if none is loaded.
+const LTexture *SpriteSet::getTexture() const {
+    return mBitmap;
+}
@@ -32,6 +32,10 @@ public:
 
     uint getNTiles() const;
 
+    bool getSpriteRect(displayID valueToDisplay, SDL_Rect &spriteRect) const;
+
+    const LTexture *getTexture() const;
+
 private:
     //Deallocates texture
     void free();
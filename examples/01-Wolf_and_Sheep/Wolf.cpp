@@ -14,7 +14,7 @@ std::vector<std::size_t> Wolf::getEntityTypeHash() {
 }
 
 EffectedType
-Wolf::tick(Iworld<Ientity, EID, Iitem, IID> *worldPointer, TileMap *map,
+Wolf::tick(Iworld<Ientity, EID, Iitem, IID> *worldPointer, const TileMap *map,
            const ObjectAndData<Ientity, EID> &selfReference, uint energy) {
     if (selfHealth == 0)
         return EffectedType::DELETED;
@@ -28,33 +28,24 @@ Wolf::tick(Iworld<Ientity, EID, Iitem, IID> *worldPointer, TileMap *map,
     while (selfEnergy >= energyNeededForMoveAndAttack) {
         selfEnergy -= energyNeededForMoveAndAttack;
 
-        SearchResult<Ientity, EID, Iitem, IID> searchResult = worldPointer->getObjectsInCircle(selfReference.coordinate(), 500, true, false);
-
-        ObjectAndData<Ientity, EID> target(nullptr, nullptr, true, 0, Coordinate());
-        uint targetDistance = 0;
-
-        for ( ; !searchResult.entitiesFound->isAtEnd(); searchResult.entitiesFound->next()) {
-            if ((searchResult.entitiesFound->id() != selfReference.id()) && (searchResult.entitiesFound->object().getObjectType() == 1)) {
-                uint entDistance = (uint) ceil(distance(selfReference.coordinate(), searchResult.entitiesFound->position()));
-                if (target.isPlaceholder()) {
-                    target = searchResult.entitiesFound->ObjectAndDataCopy();
-                    targetDistance = entDistance;
-                } else if ((entDistance < targetDistance) && (searchResult.entitiesFound->object().getHealth() != 0)) {
-                    target = searchResult.entitiesFound->ObjectAndDataCopy();
-                    targetDistance = entDistance;
-                }
-
-                if (targetDistance <= 1) {
-                    target.object().takeDamage(selfReference.id(), 10, DamageType::KINETIC);
-                    continue;
-                }
-            }
-        }
+        // Find the closest living sheep.
+        const vector<ObjectAndData<Ientity, EID>> nearestTarget = worldPointer->findNearestOfType(
+                selfReference.coordinate(), 1, [&selfReference](ObjectAndData<Ientity, EID> &entityData) {
+                    return (entityData.id() != selfReference.id()) && (entityData.object().getHealth() != 0);
+                }, 500);
 
-        if (target.isPlaceholder()) {
+        if (nearestTarget.empty()) {
             return EffectedType::NONE;
         }
 
+        ObjectAndData<Ientity, EID> target = nearestTarget.front();
+
+        // If the target is on one of the four tiles next to the wolf, attack it instead of moving.
+        if (distanceSquared(selfReference.coordinate(), target.coordinate()) <= 1) {
+            worldPointer->damageEntity(target.id(), selfReference.id(), 10, DamageType::KINETIC);
+            continue;
+        }
+
         Coordinate delta = Coordinate{1, 1};
         if (target.coordinate().x > selfReference.coordinate().x)
             delta.x = 2;
@@ -68,12 +59,18 @@ Wolf::tick(Iworld<Ientity, EID, Iitem, IID> *worldPointer, TileMap *map,
 
         Coordinate nextPos = Coordinate{(selfReference.coordinate().x + delta.x) - 1,
                                         (selfReference.coordinate().y + delta.y) - 1};
-        Tile *nextTile = map->at(nextPos);
-        if ((nextTile == nullptr) || (nextTile->wallMaterial.materialType != MaterialType::GAS))
+        const MoveResult moveResult = worldPointer->tryMove(selfReference, nextPos, PASS_GAS);
+        if (moveResult == MoveResult::MOVED)
+            wasMoved = true;
+        else if (moveResult != MoveResult::OCCUPIED)
             return EffectedType::NONE;
+    }
 
-        if (worldPointer->moveEntity(selfReference, nextPos))
-            wasMoved = true;
+    // Sleep through the ticks in which the wolf cannot gather enough energy to act.
+    const uint energyPerTick = worldPointer->getEnergyPerTick();
+    if ((energyPerTick != 0) && (selfEnergy + energyPerTick < energyNeededForMoveAndAttack)) {
+        const uint ticksToWait = (energyNeededForMoveAndAttack - selfEnergy + energyPerTick - 1) / energyPerTick;
+        worldPointer->sleepUntil(selfReference, worldPointer->getTickNumber() + ticksToWait);
     }
 
     if (wasMoved)
@@ -102,6 +99,17 @@ DisplayID Wolf::getDisplayID() {
     return entityDisplay;
 }
 
+void Wolf::saveState(ByteWriter &writer) {
+    writer.writeU32(selfHealth);
+    writer.writeU32(selfEnergy);
+}
+
+bool Wolf::loadState(ByteReader &reader) {
+    selfHealth = reader.readU32();
+    selfEnergy = reader.readU32();
+    return reader.isValid();
+}
+
 std::vector<std::size_t> Wolf::wolfHash() {
     return std::vector<std::size_t>(typeid(this).hash_code());
 }
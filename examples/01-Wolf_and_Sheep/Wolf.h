@@ -13,7 +13,7 @@ public:
 
     std::vector<std::size_t> getEntityTypeHash() override;
 
-    EffectedType tick(Iworld<Ientity, EID, Iitem, IID> *worldPointer, TileMap *map,
+    EffectedType tick(Iworld<Ientity, EID, Iitem, IID> *worldPointer, const TileMap *map,
                       const ObjectAndData<Ientity, EID> &selfReference, uint energy) override;
 
     EffectedType takeDamage(EID attacker, uint damageAmount, DamageType type) override;
@@ -26,6 +26,10 @@ public:
 
     DisplayID getDisplayID() override;
 
+    void saveState(ByteWriter &writer) override;
+
+    bool loadState(ByteReader &reader) override;
+
 protected:
     std::vector<std::size_t> wolfHash();
 
@@ -6,6 +6,8 @@
 #include "Wolf.h"
 #include "ltimer.h"
 #include "SpriteSet.h"
+#include "SpriteBatch.h"
+#include "PixelSpriteSet.h"
 #include "../../src/ColorList.h"
 #include "ItemTestStick.h"
 #include "SpriteInteractionsList.h"
@@ -15,12 +17,18 @@
 #include <SDL.h>
 #include <vector>
 #include <fstream>
+#include <cstring>
 #include <SDL_image.h>
 
-const uint WORLD_HEIGHT = 100;
-const uint WORLD_WIDTH = 100;
+const uint WORLD_HEIGHT = 300;
+const uint WORLD_WIDTH = 300;
 const uint ENERGY_PER_TICK = 100;
 
+// Camera constants. The camera shows VIEW_WIDTH by VIEW_HEIGHT tiles, and the arrow keys move it by CAMERA_STEP tiles.
+const uint VIEW_HEIGHT = 100;
+const uint VIEW_WIDTH = 100;
+const uint CAMERA_STEP = 10;
+
 // Sprite, SI, color, and file name constants
 const SpriteInteraction TI_ERROR = SpriteInteraction{"TI_ERROR", 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3};
 const SDL_Color COLOR_ERROR = SDL_Color{0xFF, 0x00, 0xFF};
@@ -35,8 +43,8 @@ const uint MAX_COLOR = 500;
 // Screen constants
 const int SCREEN_FPS = 60;
 const int SCREEN_TICKS_PER_FRAME = 1000 / SCREEN_FPS;
-const int SCREEN_WIDTH = TILE_WIDTH * WORLD_WIDTH;
-const int SCREEN_HEIGHT = TILE_HEIGHT * WORLD_HEIGHT;
+const int SCREEN_WIDTH = TILE_WIDTH * VIEW_WIDTH;
+const int SCREEN_HEIGHT = TILE_HEIGHT * VIEW_HEIGHT;
 
 // The window we'll be rendering to
 SDL_Window *gWindow = nullptr;
@@ -50,7 +58,9 @@ void setWorldWallToMaterial(TileMap &map, Material m, uint h);
 
 void drawLineOfWalls(TileMap &map, Coordinate start, Coordinate end, Material m, uint health);
 
-bool init();
+void moveCamera(ViewRect &camera, SDL_Keycode key);
+
+bool init(bool isSoftwareRenderer);
 
 bool loadSpriteSetFromFile(SDL_Renderer *renderer, SpriteSet &spriteSet, const std::string &fileName);
 
@@ -59,13 +69,29 @@ void close();
 int main(int argc, char *args[]) {
     printf("--WELT--\n");
 
-    // Start SDL and create window
-    if (!init()) {
+    // Start SDL and create window. Pass --software to draw without a GPU, and --pixels to build each
+    //   frame in memory with a PixelSpriteSet instead of drawing sprites with the renderer.
+    //   Pass --trace FILE to write a Chrome trace of the run, in a build with WELT_TRACE.
+    bool isSoftwareRenderer = false, isPixelRenderer = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(args[i], "--software") == 0) {
+            isSoftwareRenderer = true;
+        } else if (strcmp(args[i], "--pixels") == 0) {
+            isPixelRenderer = true;
+        } else if ((strcmp(args[i], "--trace") == 0) && (i + 1 < argc)) {
+            Trace::setThreadName("main");
+            if (!Trace::start(args[++i]))
+                printf("!Could not write the trace file \"%s\"!\n", args[i]);
+        }
+    }
+
+    if (!init(isSoftwareRenderer)) {
         printf("!Failed to initialize SDL! Closing...\n");
     } else {
         // Create and load the resources. If something fails to load, allResourcesLoaded will be
         //   set to false.
         SpriteSet sprites;
+        PixelSpriteSet pixelSprites;
         SpriteInteractionsList tileI;
         ColorList colors;
         bool allResourcesLoaded = true;
@@ -75,6 +101,9 @@ int main(int argc, char *args[]) {
             allResourcesLoaded = false;
         if (!loadSpriteSetFromFile(gRenderer, sprites, spriteSetFileName))
             allResourcesLoaded = false;
+        if (isPixelRenderer && !pixelSprites.loadFromFile(
+                getResourcePath("example-01-Wolf_and_Sheep/tileset") + spriteSetFileName, TILE_WIDTH, TILE_HEIGHT))
+            allResourcesLoaded = false;
 
         // If all resources were not loaded, exit the application.
         if (!allResourcesLoaded) {
@@ -96,16 +125,37 @@ int main(int argc, char *args[]) {
             SDL_Rect mapViewRect;
             mapViewRect.x = 0;
             mapViewRect.y = 0;
-            mapViewRect.w = TILE_WIDTH * WORLD_WIDTH;
-            mapViewRect.h = TILE_HEIGHT * WORLD_HEIGHT;
+            mapViewRect.w = SCREEN_WIDTH;
+            mapViewRect.h = SCREEN_HEIGHT;
             SDL_RenderSetViewport(gRenderer, &mapViewRect);
 
             // Create a timer to regulate the FPS. Without this, the application
             //   will render as fast as possible. This would waste system resources.
             LTimer fpsReg;
 
-            // Create a DisplayArray so we can get data out of the world.
+            // Create a DisplayArray so we can get data out of the world, and a camera to choose
+            //   what part of the world is loaded into it.
             DisplayArray dis;
+            ViewRect camera{0, 0, VIEW_WIDTH, VIEW_HEIGHT};
+            std::vector<ResolvedSprite> resolvedSprites;
+
+            // Sprites are either collected into a batch and drawn with one call per frame, or drawn into
+            //   a frame in memory that is copied to a streaming texture.
+            SpriteBatch spriteBatch(sprites);
+            PixelFrame frame;
+            SDL_Texture *frameTexture = nullptr;
+            if (isPixelRenderer) {
+                resizePixelFrame(frame, SCREEN_WIDTH, SCREEN_HEIGHT);
+                frameTexture = SDL_CreateTexture(gRenderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING,
+                                                 SCREEN_WIDTH, SCREEN_HEIGHT);
+            }
+            const displayID errorSprite = tileI.get(0).dDefault;
+            auto drawSprite = [&](int x, int y, displayID sprite, const SDL_Color &color) {
+                if (isPixelRenderer)
+                    pixelSprites.blit(frame, x, y, sprite, color);
+                else
+                    spriteBatch.add(x, y, sprite, color);
+            };
 
             // Create a chunk and load it with some test data.
             World a(WORLD_HEIGHT, WORLD_WIDTH, ENERGY_PER_TICK);
@@ -141,6 +191,7 @@ int main(int argc, char *args[]) {
 
             //While application is running
             while (!quit) {
+                WELT_TRACE_ZONE("frame");
                 fpsReg.start();
 
                 // If there are events in the que, try to process them,
@@ -148,6 +199,8 @@ int main(int argc, char *args[]) {
                     // If the user wants to quit the app, signal to exit.
                     if (eventH.type == SDL_QUIT) {
                         quit = true;
+                    } else if (eventH.type == SDL_KEYDOWN) {
+                        moveCamera(camera, eventH.key.keysym.sym);
                     }
                 }
 
@@ -160,43 +213,51 @@ int main(int argc, char *args[]) {
                 SDL_RenderFillRect(gRenderer, &screenRect);
                 SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xFF);
 
-                // Load the DisplayArray with the display data for the chunk.
-                a.loadDisplayArray(dis);
+                // Load the DisplayArray with the display data for the part of the world the camera sees.
+                a.loadDisplayArray(dis, camera);
+
+                // Work out which sprite connects each element to its neighbours.
+                tileI.resolveSprites(dis, resolvedSprites);
 
-                // Draw the background elements to the renderer.
+                // Draw the elements, background first.
+                spriteBatch.clear();
+                clearPixelFrame(frame, SDL_Color{0, 0, 0, 0xFF});
                 for (uint row = 0; row < dis.height; row++) {
                     for (uint col = 0; col < dis.width; col++) {
                         DisplayArrayElement currentElement = dis.displayData[col + (dis.width * row)];
+                        const ResolvedSprite &currentSprites = resolvedSprites[col + (dis.width * row)];
                         // Draw the background elements.
                         // If the Sprite is not in the SpriteSet or is defined as invalid, print the error sprite. (sprite 0)
                         if (sprites.getNTiles() <= currentElement.BackgroundInfo) {
-                            sprites.setColor(COLOR_ERROR);
-                            sprites.render(col * TILE_WIDTH, row * TILE_HEIGHT, tileI.get(0).dDefault);
+                            drawSprite(col * TILE_WIDTH, row * TILE_HEIGHT, errorSprite, COLOR_ERROR);
                         } else {
                             SDL_Color backgroundColor = colors.get(currentElement.BackgroundColor);
-
-                            sprites.setColor(backgroundColor);
-                            sprites.render(col * TILE_WIDTH, row * TILE_HEIGHT,
-                                           tileI.getBackgroundTileFromDisplayArray(col, row, dis));
+                            drawSprite(col * TILE_WIDTH, row * TILE_HEIGHT, currentSprites.background, backgroundColor);
                         }
 
                         // Draw the foreground elements.
                         // If the Sprite is not in the SpriteSet or is defined as invalid, print the error sprite. (sprite 0)
                         if (sprites.getNTiles() <= currentElement.ForegroundInfo) {
-                            sprites.setColor(COLOR_ERROR);
-                            sprites.render(col * TILE_WIDTH, row * TILE_HEIGHT, tileI.get(0).dDefault);
+                            drawSprite(col * TILE_WIDTH, row * TILE_HEIGHT, errorSprite, COLOR_ERROR);
                         } else {
                             SDL_Color foregroundColor = colors.get(currentElement.ForegroundColor);
-
-                            sprites.setColor(foregroundColor);
-                            sprites.render(col * TILE_WIDTH, row * TILE_HEIGHT,
-                                           tileI.getForegroundTileFromDisplayArray(col, row, dis));
+                            drawSprite(col * TILE_WIDTH, row * TILE_HEIGHT, currentSprites.foreground, foregroundColor);
                         }
                     }
                 }
 
-                // Update screen with the contents of the renderer.
-                SDL_RenderPresent(gRenderer);
+                // Draw every element to the renderer at once, and update the screen with the contents of the renderer.
+                {
+                    WELT_TRACE_ZONE("render");
+                    if (isPixelRenderer) {
+                        copyPixelFrameToTexture(frame, frameTexture);
+                        SDL_RenderCopy(gRenderer, frameTexture, nullptr, &screenRect);
+                    } else {
+                        spriteBatch.draw(gRenderer);
+                    }
+
+                    SDL_RenderPresent(gRenderer);
+                }
 
                 // Wait out the rest of the frame.
                 //int elapsedTicks = fpsReg.getTicks();
@@ -208,18 +269,37 @@ int main(int argc, char *args[]) {
 
                 printf("Tick: %u\n", a.getTickNumber());
             }
+
+            SDL_DestroyTexture(frameTexture);
         }
     }
 
-    // If the user has chosen to exit, free resources and close SDL.
+    // If the user has chosen to exit, finish the trace, free resources and close SDL.
+    Trace::stop();
     close();
 
     return 0;
 }
 
-// Initializes SDL2, creates a window, and creates a renderer.
+// Moves the camera in the direction of the arrow key, keeping it inside the world.
+void moveCamera(ViewRect &camera, SDL_Keycode key) {
+    const uint maxX = WORLD_WIDTH - VIEW_WIDTH;
+    const uint maxY = WORLD_HEIGHT - VIEW_HEIGHT;
+
+    if (key == SDLK_LEFT)
+        camera.x = (camera.x > CAMERA_STEP) ? camera.x - CAMERA_STEP : 0;
+    else if (key == SDLK_RIGHT)
+        camera.x = std::min(camera.x + CAMERA_STEP, maxX);
+    else if (key == SDLK_UP)
+        camera.y = (camera.y > CAMERA_STEP) ? camera.y - CAMERA_STEP : 0;
+    else if (key == SDLK_DOWN)
+        camera.y = std::min(camera.y + CAMERA_STEP, maxY);
+}
+
+// Initializes SDL2, creates a window, and creates a renderer. If isSoftwareRenderer is true,
+//   the renderer draws on the CPU instead of the GPU.
 // Call before using any SDL2 resources.
-bool init() {
+bool init(bool isSoftwareRenderer) {
     //Initialization flag
     bool success = true;
 
@@ -241,7 +321,8 @@ bool init() {
             success = false;
         } else {
             //Create renderer for window
-            gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED);
+            gRenderer = SDL_CreateRenderer(gWindow, -1,
+                                           isSoftwareRenderer ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED);
             if (gRenderer == nullptr) {
                 printf("!Renderer could not be created. SDL Error: %s\n !", SDL_GetError());
                 success = false;
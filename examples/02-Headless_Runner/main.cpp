@@ -0,0 +1,284 @@
+// main.cpp : Ticks the Wolf and Sheep scenario as fast as possible, without SDL or a window.
+//
+// Usage: welt_headless [ticks] [width] [height] [--parallel] [--workers N] [--profile] [--trace FILE]
+//                      [--load FILE] [--save FILE] [--record FILE] [--replay FILE]
+//   --profile  Print the World's tick stats at the end. Needs a build with WELT_PROFILE.
+//   --trace    Write a Chrome trace of the run to FILE. Needs a build with WELT_TRACE.
+//   --load     Start from the world snapshot in FILE instead of the scenario. The width and height are ignored.
+//   --save     Write a snapshot of the world to FILE after the ticks.
+//   --record   Write a journal of every change during the ticks to FILE, and the world it starts from to
+//              FILE.snapshot.
+//   --replay   Play back up to [ticks] ticks of the journal in FILE onto FILE.snapshot, without ticking entities.
+
+#include "../../src/world.h"
+#include "../../src/DeltaJournal.h"
+#include "../01-Wolf_and_Sheep/Sheep.h"
+#include "../01-Wolf_and_Sheep/Wolf.h"
+#include "../01-Wolf_and_Sheep/ItemTestStick.h"
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+const uint DEFAULT_TICKS = 1000;
+const uint DEFAULT_WORLD_HEIGHT = 100;
+const uint DEFAULT_WORLD_WIDTH = 100;
+const uint ENERGY_PER_TICK = 100;
+
+// Prints how to run the program, for when it is given arguments it does not understand.
+void printUsage() {
+    printf("Usage: welt_headless [ticks] [width] [height] [--parallel] [--workers N] [--profile] [--trace FILE]\n"
+           "                     [--load FILE] [--save FILE] [--record FILE] [--replay FILE]\n");
+}
+
+// Reads the whole of text as a number that fits in a uint. Returns false if it is not one.
+bool readNumber(const char *text, uint &value) {
+    if ((text[0] < '0') || (text[0] > '9'))
+        return false;
+
+    char *end;
+    const unsigned long long number = strtoull(text, &end, 10);
+    if ((*end != '\0') || (number > UINT_MAX))
+        return false;
+
+    value = (uint) number;
+    return true;
+}
+
+// Sets up the same world as the SDL example: grass floor, no walls, the bottom half full of sheep,
+//   a wolf in the corner, and a test item.
+void loadScenario(World &world, uint height, uint width) {
+    Material grassTmp = M_GRASS;
+    Material airTmp = M_AIR;
+    for (uint row = 0; row < height; row++) {
+        for (uint column = 0; column < width; column++) {
+            world.getMap()->setFloorMaterial(Coordinate{column, row}, grassTmp);
+            world.getMap()->setWallMaterial(Coordinate{column, row}, airTmp, airTmp.baseHealth);
+        }
+    }
+
+    for (uint row = (height / 2); row < height; row++) {
+        for (uint column = 0; column < width; column++)
+            world.addEntity(new Sheep, Coordinate{column, row});
+    }
+
+    world.addEntity(new Wolf, Coordinate{0, 0});
+    world.addItem(new ItemTestStick, Coordinate{std::min(5u, width - 1), std::min(5u, height - 1)});
+}
+
+// Registers the types of the scenario, so they can be saved to and loaded from snapshots.
+SnapshotRegistry scenarioRegistry() {
+    SnapshotRegistry registry;
+    registry.registerEntity<Sheep>("Sheep");
+    registry.registerEntity<Wolf>("Wolf");
+    registry.registerItem<ItemTestStick>("ItemTestStick");
+    return registry;
+}
+
+// Prints where the time of the ticks went, from the World's stats.
+void printStats(const TickProfiler &stats) {
+#ifndef WELT_PROFILE
+    printf("Tick stats are not collected. Configure with -DWELT_PROFILE=ON to collect them.\n");
+    return;
+#endif
+    const TickStats &totals = stats.totals();
+    const double tickMs = (totals.tickMs > 0) ? totals.tickMs : 1;
+    printf("Tick time %.3f ms: collect %.1f%%, entities %.1f%%, commit %.1f%%\n", totals.tickMs,
+           100 * totals.phaseMs[(uint) TickPhase::COLLECT] / tickMs,
+           100 * totals.phaseMs[(uint) TickPhase::ENTITIES] / tickMs,
+           100 * totals.phaseMs[(uint) TickPhase::COMMIT] / tickMs);
+
+    for (uint objectType = 0; objectType < totals.entityTypes.size(); objectType++) {
+        const EntityTypeStats &type = totals.entityTypes[objectType];
+        if (type.nTicked != 0)
+            printf("  Object type %u: %llu ticked, %.3f ms, %.3f us each\n", objectType, type.nTicked, type.ms,
+                   1000 * type.ms / type.nTicked);
+    }
+
+    printf("Queries %llu, chunks scanned %llu, candidates tested %llu, accepted %llu\n", totals.queries.queries,
+           totals.queries.chunksScanned, totals.queries.candidatesTested, totals.queries.candidatesAccepted);
+    printf("Moves committed %u, rejected %u, entities added %u, deleted %u\n", totals.movesCommitted,
+           totals.movesRejected, totals.entitiesAdded, totals.entitiesDeleted);
+
+    // Find the slowest of the recent ticks.
+    if (stats.historySize() != 0) {
+        uint slowest = 0;
+        for (uint i = 1; i < stats.historySize(); i++) {
+            if (stats.recent(i).tickMs > stats.recent(slowest).tickMs)
+                slowest = i;
+        }
+        printf("Slowest of the last %u ticks: tick %u, %.3f ms\n", stats.historySize(),
+               stats.recent(slowest).tickNumber, stats.recent(slowest).tickMs);
+    }
+}
+
+int main(int argc, char *args[]) {
+    uint ticks = DEFAULT_TICKS, height = DEFAULT_WORLD_HEIGHT, width = DEFAULT_WORLD_WIDTH, workers = 0;
+    bool isParallel = false, isProfilePrinted = false;
+    const char *tracePath = nullptr, *loadPath = nullptr, *savePath = nullptr, *recordPath = nullptr;
+    const char *replayPath = nullptr;
+
+    // Read the options, then the numbers in the order ticks, width, height. Anything else is an error,
+    //   so that a mistyped option is not taken for a number.
+    uint nNumbers = 0;
+    for (int i = 1; i < argc; i++) {
+        const char *option = args[i];
+        if (strcmp(option, "--parallel") == 0) {
+            isParallel = true;
+        } else if (strcmp(option, "--profile") == 0) {
+            isProfilePrinted = true;
+        } else if (strncmp(option, "--", 2) == 0) {
+            const char **path = nullptr;
+            if (strcmp(option, "--trace") == 0)
+                path = &tracePath;
+            else if (strcmp(option, "--load") == 0)
+                path = &loadPath;
+            else if (strcmp(option, "--save") == 0)
+                path = &savePath;
+            else if (strcmp(option, "--record") == 0)
+                path = &recordPath;
+            else if (strcmp(option, "--replay") == 0)
+                path = &replayPath;
+
+            if (!path && (strcmp(option, "--workers") != 0)) {
+                printf("!Unknown option \"%s\"!\n", option);
+                printUsage();
+                return 1;
+            }
+
+            if (i + 1 >= argc) {
+                printf("!The option %s needs a value!\n", option);
+                printUsage();
+                return 1;
+            }
+
+            if (path) {
+                *path = args[++i];
+            } else if (!readNumber(args[++i], workers)) {
+                printf("!The number of workers \"%s\" is not a number!\n", args[i]);
+                printUsage();
+                return 1;
+            }
+        } else {
+            uint value;
+            if (!readNumber(option, value) || (nNumbers >= 3)) {
+                printf("!Unexpected argument \"%s\"!\n", option);
+                printUsage();
+                return 1;
+            }
+
+            if (nNumbers == 0)
+                ticks = value;
+            else if (nNumbers == 1)
+                width = value;
+            else
+                height = value;
+            nNumbers++;
+        }
+    }
+
+    if ((width == 0) || (height == 0)) {
+        printf("!The world must not have any dimension that is zero!\n");
+        return 1;
+    }
+
+    printf("--WELT headless--\n");
+    const SnapshotRegistry registry = scenarioRegistry();
+    std::unique_ptr<World> worldPointer;
+    const std::string replaySnapshotPath = replayPath ? std::string(replayPath) + ".snapshot" : std::string();
+    if (replayPath)
+        loadPath = replaySnapshotPath.c_str();
+    if (loadPath) {
+        std::string error;
+        const auto loadStart = std::chrono::steady_clock::now();
+        worldPointer = WorldSnapshot::load(loadPath, registry, &error);
+        if (!worldPointer) {
+            printf("!Could not load the snapshot \"%s\": %s!\n", loadPath, error.c_str());
+            return 1;
+        }
+        printf("Loaded \"%s\" at tick %u in %.3f ms\n", loadPath, worldPointer->getTickNumber(),
+               std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count());
+        width = worldPointer->getMap()->width();
+        height = worldPointer->getMap()->height();
+    } else {
+        worldPointer.reset(new World(height, width, ENERGY_PER_TICK));
+        loadScenario(*worldPointer, height, width);
+    }
+
+    World &world = *worldPointer;
+    world.setWorkerCount(workers);
+    world.setParallelTick(isParallel);
+    printf("World %ux%u, %u ticks, %s tick\n", width, height, ticks, isParallel ? "parallel" : "serial");
+
+    if (tracePath) {
+#ifndef WELT_TRACE
+        printf("Trace zones are not compiled in. Configure with -DWELT_TRACE=ON to record them.\n");
+#endif
+        Trace::setThreadName("main");
+        if (!Trace::start(tracePath)) {
+            printf("!Could not write the trace file \"%s\"!\n", tracePath);
+            return 1;
+        }
+    }
+
+    DeltaJournal journal;
+    if (recordPath) {
+        std::string error;
+        if (!journal.start(world, recordPath, std::string(recordPath) + ".snapshot", registry, &error)) {
+            printf("!Could not record the journal \"%s\": %s!\n", recordPath, error.c_str());
+            return 1;
+        }
+    }
+
+    JournalReplay replay;
+    if (replayPath) {
+        std::string error;
+        if (!replay.open(replayPath, world, registry, &error)) {
+            printf("!Could not open the journal \"%s\": %s!\n", replayPath, error.c_str());
+            return 1;
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    if (replayPath) {
+        ticks = replay.replayUntil(world.getTickNumber() + ticks);
+    } else {
+        for (uint i = 0; i < ticks; i++)
+            world.tick();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    Trace::stop();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    printf("%s %u ticks in %.3f s (%.1f ticks/s) with %u workers\n", replayPath ? "Replayed" : "Ran", ticks, seconds,
+           (seconds > 0) ? (ticks / seconds) : 0.0, world.workerCount());
+
+    if (!replay.error().empty()) {
+        printf("!Could not replay the journal \"%s\": %s!\n", replayPath, replay.error().c_str());
+        return 1;
+    }
+
+    if (recordPath) {
+        std::string error;
+        if (!journal.stop(&error)) {
+            printf("!Could not record the journal \"%s\": %s!\n", recordPath, error.c_str());
+            return 1;
+        }
+        printf("Recorded \"%s\" from tick %u\n", recordPath, world.getTickNumber() - ticks);
+    }
+
+    if (isProfilePrinted)
+        printStats(world.stats());
+
+    if (savePath) {
+        std::string error;
+        if (!WorldSnapshot::save(world, savePath, registry, &error)) {
+            printf("!Could not save the snapshot \"%s\": %s!\n", savePath, error.c_str());
+            return 1;
+        }
+        printf("Saved \"%s\" at tick %u\n", savePath, world.getTickNumber());
+    }
+
+    return 0;
+}
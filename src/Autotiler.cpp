@@ -0,0 +1,84 @@
+#include "Autotiler.h"
+#include "TraceWriter.h"
+
+// Returns the neighbour mask of the element at (col, row) for the layer that member points to.
+uint Autotiler::getNeighbourMask(uint col, uint row, const DisplayArray &dis,
+                                 DisplayID DisplayArrayElement::*member) {
+    const DisplayArrayElement *element = dis.displayData + col + (dis.width * row);
+    const DisplayID id = element->*member;
+
+    uint mask = 0;
+    if ((col != 0) && ((element - 1)->*member == id))
+        mask |= 1u;
+    if ((col != dis.width - 1) && ((element + 1)->*member == id))
+        mask |= 2u;
+    if ((row != dis.height - 1) && ((element + dis.width)->*member == id))
+        mask |= 4u;
+    if ((row != 0) && ((element - dis.width)->*member == id))
+        mask |= 8u;
+
+    return mask;
+}
+
+// Computes the neighbour mask of every cell of a grid of displayIDs. Each direction is a separate pass
+//   of branch-free compares over a row, so the compiler can vectorize them.
+static void computeNeighbourMasks(const displayID *ids, uint width, uint height, uint8_t *masks) {
+    for (uint row = 0; row < height; row++) {
+        const displayID *rowIDs = ids + ((size_t) row * width);
+        uint8_t *rowMasks = masks + ((size_t) row * width);
+
+        std::fill(rowMasks, rowMasks + width, 0);
+        for (uint col = 1; col < width; col++)
+            rowMasks[col] |= (uint8_t) (rowIDs[col] == rowIDs[col - 1]);
+        for (uint col = 0; col + 1 < width; col++)
+            rowMasks[col] |= (uint8_t) ((rowIDs[col] == rowIDs[col + 1]) << 1);
+        if (row + 1 < height) {
+            const displayID *belowIDs = rowIDs + width;
+            for (uint col = 0; col < width; col++)
+                rowMasks[col] |= (uint8_t) ((rowIDs[col] == belowIDs[col]) << 2);
+        }
+        if (row != 0) {
+            const displayID *aboveIDs = rowIDs - width;
+            for (uint col = 0; col < width; col++)
+                rowMasks[col] |= (uint8_t) ((rowIDs[col] == aboveIDs[col]) << 3);
+        }
+    }
+}
+
+// Fills the lookup table from the first nSI entries of the SI list. Entries that were never defined get the
+//   list's default SpriteInteraction, which is also used for every displayID past the end of the table.
+void Autotiler::build(const flat::FlatVector<SpriteInteraction> &SI_list, const uint nSI) {
+    nTableEntries = nSI + 1;
+    spriteTable.resize((size_t) nTableEntries << 4);
+
+    for (uint i = 0; i < nTableEntries; i++) {
+        const SpriteInteraction SI = (i + 1 < nTableEntries) ? SI_list.get(i) : SI_list.getDefault();
+        const displayID sprites[16] = {SI.dDefault, SI.W, SI.E, SI.EW, SI.S, SI.SW, SI.SE, SI.SEW,
+                                       SI.N, SI.NW, SI.NE, SI.NEW, SI.NS, SI.NSW, SI.NSE, SI.NSEW};
+        std::copy(sprites, sprites + 16, spriteTable.begin() + ((size_t) i << 4));
+    }
+}
+
+// Determines the background and foreground sprites of every element of the DisplayArray at once, and
+//   writes them to resolved, which is resized to match.
+void Autotiler::resolveSprites(const DisplayArray &dis, std::vector<ResolvedSprite> &resolved) const {
+    WELT_TRACE_ZONE("Autotiler::resolveSprites");
+    const size_t nElements = (size_t) dis.width * dis.height;
+    resolved.resize(nElements);
+    layerIDs.resize(nElements);
+    layerMasks.resize(nElements);
+
+    // Resolve the background layer.
+    for (size_t i = 0; i < nElements; i++)
+        layerIDs[i] = dis.displayData[i].BackgroundInfo;
+    computeNeighbourMasks(layerIDs.data(), dis.width, dis.height, layerMasks.data());
+    for (size_t i = 0; i < nElements; i++)
+        resolved[i].background = lookup(layerIDs[i], layerMasks[i]);
+
+    // Resolve the foreground layer.
+    for (size_t i = 0; i < nElements; i++)
+        layerIDs[i] = dis.displayData[i].ForegroundInfo;
+    computeNeighbourMasks(layerIDs.data(), dis.width, dis.height, layerMasks.data());
+    for (size_t i = 0; i < nElements; i++)
+        resolved[i].foreground = lookup(layerIDs[i], layerMasks[i]);
+}
@@ -0,0 +1,44 @@
+#ifndef WELT_AUTOTILER_H
+#define WELT_AUTOTILER_H
+
+#include "universal.h"
+#include "DisplayIDdef.h"
+#include "../include/FlatVector.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// The sprites to draw for one element of a DisplayArray, after connecting it to its neighbours.
+struct ResolvedSprite {
+    displayID background, foreground;
+};
+
+// Picks the sprite for each element of a DisplayArray from its SpriteInteraction and which of its
+//   neighbours share its displayID, so walls and fences connect.
+// Sprites are looked up through a flat table with 16 entries per SpriteInteraction, one for each
+//   neighbour mask. Bit 0 of a mask is set if the west neighbour has the same displayID, bit 1 east,
+//   bit 2 south and bit 3 north, which matches the order of the fields of SpriteInteraction.
+class Autotiler {
+public:
+    Autotiler() = default;
+
+    void build(const flat::FlatVector<SpriteInteraction> &SI_list, uint nSI);
+
+    // Returns the sprite for the given displayID and neighbour mask.
+    displayID lookup(displayID id, uint mask) const {
+        return spriteTable[(std::min(id, nTableEntries - 1) << 4) | mask];
+    }
+
+    static uint getNeighbourMask(uint col, uint row, const DisplayArray &dis, DisplayID DisplayArrayElement::*member);
+
+    void resolveSprites(const DisplayArray &dis, std::vector<ResolvedSprite> &resolved) const;
+
+private:
+    std::vector<displayID> spriteTable = std::vector<displayID>(16, 0); // 16 per SI, then 16 for the default.
+    uint nTableEntries = 1;
+    mutable std::vector<displayID> layerIDs; // Scratch space for resolveSprites.
+    mutable std::vector<uint8_t> layerMasks;
+};
+
+
+#endif //WELT_AUTOTILER_H
@@ -0,0 +1,136 @@
+#ifndef WELT_BYTESTREAM_H
+#define WELT_BYTESTREAM_H
+
+#include "universal.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Appends values to a buffer of bytes, in the byte order of the machine.
+class ByteWriter {
+public:
+    ByteWriter() = default;
+
+    void writeU8(uint8_t value) { buffer.push_back(value); }
+
+    void writeU16(uint16_t value) { this->writeBytes(&value, sizeof(value)); }
+
+    void writeU32(uint32_t value) { this->writeBytes(&value, sizeof(value)); }
+
+    void writeU64(uint64_t value) { this->writeBytes(&value, sizeof(value)); }
+
+    // Writes the value in as few bytes as it needs, seven bits to a byte, lowest bits first.
+    void writeVarint(uint64_t value) {
+        while (value >= 0x80) {
+            buffer.push_back((uint8_t) (value | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back((uint8_t) value);
+    }
+
+    // Writes a signed value as a varint, so that small negative values are as short as small positive ones.
+    void writeSignedVarint(int64_t value) { this->writeVarint(((uint64_t) value << 1) ^ (uint64_t) (value >> 63)); }
+
+    // Writes a length followed by the characters of the string.
+    void writeString(const std::string &value) {
+        this->writeU32((uint32_t) value.size());
+        this->writeBytes(value.data(), value.size());
+    }
+
+    void writeBytes(const void *data, size_t size) {
+        const uint8_t *bytes = (const uint8_t *) data;
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+
+    std::vector<uint8_t> &bytes() { return buffer; }
+
+    size_t size() const { return buffer.size(); }
+
+private:
+    std::vector<uint8_t> buffer;
+};
+
+// Reads values written by a ByteWriter from a range of bytes it does not own. Reading past the end of the
+//   range returns zeros and makes the reader invalid, so a reader can read a whole record and check
+//   isValid once at the end.
+class ByteReader {
+public:
+    ByteReader(const uint8_t *data, size_t size) : data(data), size(size), position(0), isReadValid(true) {}
+
+    uint8_t readU8() { return this->read<uint8_t>(); }
+
+    uint16_t readU16() { return this->read<uint16_t>(); }
+
+    uint32_t readU32() { return this->read<uint32_t>(); }
+
+    uint64_t readU64() { return this->read<uint64_t>(); }
+
+    uint64_t readVarint() {
+        uint64_t value = 0;
+        for (uint shift = 0; shift < 64; shift += 7) {
+            const uint8_t byte = this->readU8();
+            value |= (uint64_t) (byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return isReadValid ? value : 0;
+        }
+
+        // Too long to be a varint written by ByteWriter.
+        isReadValid = false;
+        return 0;
+    }
+
+    int64_t readSignedVarint() {
+        const uint64_t value = this->readVarint();
+        return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+    }
+
+    std::string readString() {
+        const uint32_t length = this->readU32();
+        if (!this->canRead(length))
+            return std::string();
+
+        std::string value((const char *) data + position, length);
+        position += length;
+        return value;
+    }
+
+    // Returns a pointer to the next size bytes and skips over them, or nullptr if there are not enough.
+    const uint8_t *readBytes(size_t length) {
+        if (!this->canRead(length))
+            return nullptr;
+
+        const uint8_t *bytes = data + position;
+        position += length;
+        return bytes;
+    }
+
+    // Returns true if nothing has been read past the end.
+    bool isValid() const { return isReadValid; }
+
+    bool isAtEnd() const { return position == size; }
+
+private:
+    const uint8_t *data;
+    size_t size, position;
+    bool isReadValid;
+
+    bool canRead(size_t length) {
+        if (isReadValid && (length <= size - position))
+            return true;
+
+        isReadValid = false;
+        return false;
+    }
+
+    template<class Value>
+    Value read() {
+        Value value = 0;
+        if (this->canRead(sizeof(Value))) {
+            memcpy(&value, data + position, sizeof(Value));
+            position += sizeof(Value);
+        }
+        return value;
+    }
+};
+
+#endif //WELT_BYTESTREAM_H
@@ -0,0 +1,588 @@
+#include "DeltaJournal.h"
+
+#include <cstring>
+
+const char JOURNAL_MAGIC[8] = {'W', 'E', 'L', 'T', 'J', 'R', 'N', 'L'};
+
+// Records are handed to the writer thread at the end of a tick once there are at least this many bytes of them.
+const size_t JOURNAL_BLOCK_BYTES = 1 << 16;
+
+DeltaJournal::~DeltaJournal() {
+    this->stop();
+}
+
+// Saves a snapshot of the world to snapshotPath, then starts recording its changes to the journal at path,
+//   replacing both files. Returns true if successful. If not, the reason is stored in error, if it is given.
+bool DeltaJournal::start(World &world, const std::string &path, const std::string &snapshotPath,
+                         const SnapshotRegistry &registry, std::string *error) {
+    if (this->isRecording() || world.journal) {
+        if (error)
+            *error = "The world is already being recorded";
+        return false;
+    }
+
+    if (!WorldSnapshot::save(world, snapshotPath, registry, error))
+        return false;
+
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        if (error)
+            *error = "Could not open " + path + " for writing";
+        return false;
+    }
+
+    ByteWriter header;
+    header.writeBytes(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    header.writeU32(JOURNAL_VERSION);
+    header.writeU32(world.tickNumber);
+    header.writeU32(world.map->width());
+    header.writeU32(world.map->height());
+    if (fwrite(header.bytes().data(), 1, header.size(), file) != header.size()) {
+        fclose(file);
+        file = nullptr;
+        if (error)
+            *error = "Could not write " + path;
+        return false;
+    }
+
+    this->registry = &registry;
+    failure.clear();
+    records.bytes().clear();
+    lastTile = Coordinate{0, 0};
+    nKnownMaterials = world.map->materials.size();
+    entityTypeNumbers.clear();
+    itemTypeNumbers.clear();
+    entityStatuses.clear();
+    touchedSlots.clear();
+    isStopping = false;
+    isWriteFailed = false;
+    writer = std::thread(&DeltaJournal::writerLoop, this);
+
+    recordedWorld = &world;
+    world.journal = this;
+    world.map->journal = this;
+    return true;
+}
+
+// Stops recording, and writes every record left. Returns true if the whole journal was written. If not, the
+//   reason is stored in error, if it is given. The journal is still valid up to the last tick written.
+bool DeltaJournal::stop(std::string *error) {
+    if (!file)
+        return true;
+
+    this->detach();
+    this->handOffRecords();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isStopping = true;
+    }
+    blocksChanged.notify_all();
+    writer.join();
+
+    const bool isWritten = (fclose(file) == 0) && !isWriteFailed;
+    file = nullptr;
+    if (failure.empty() && !isWritten)
+        failure = "Could not write the journal";
+    if (!failure.empty() && error)
+        *error = failure;
+    return failure.empty();
+}
+
+// Stops the World and its TileMap from reporting changes.
+void DeltaJournal::detach() {
+    if (!recordedWorld)
+        return;
+
+    recordedWorld->journal = nullptr;
+    recordedWorld->map->journal = nullptr;
+    recordedWorld = nullptr;
+}
+
+// Records every material added to the registry since the last one recorded, up to newestMaterial.
+void DeltaJournal::recordMaterials(MaterialID newestMaterial, const MaterialRegistry &materials) {
+    for (; nKnownMaterials <= newestMaterial; nKnownMaterials++) {
+        const Material &material = materials.get((MaterialID) nKnownMaterials);
+        records.writeU8((uint8_t) JournalRecord::MATERIAL);
+        records.writeVarint((uint) material.materialType);
+        records.writeVarint(material.baseHealth);
+        records.writeVarint(material.color);
+        records.writeVarint(material.defaultDisplayWall);
+        records.writeVarint(material.defaultDisplayFloor);
+    }
+}
+
+// Writes the tile as a change from the last tile recorded. Tiles are usually set in rows, so this is one
+//   or two bytes.
+void DeltaJournal::recordTileMove(const Coordinate &cord) {
+    records.writeSignedVarint((int64_t) cord.x - lastTile.x);
+    records.writeSignedVarint((int64_t) cord.y - lastTile.y);
+    lastTile = cord;
+}
+
+void DeltaJournal::recordFloor(const Coordinate &cord, MaterialID material, const MaterialRegistry &materials) {
+    this->recordMaterials(material, materials);
+    records.writeU8((uint8_t) JournalRecord::FLOOR);
+    this->recordTileMove(cord);
+    records.writeVarint(material);
+}
+
+void DeltaJournal::recordWall(const Coordinate &cord, MaterialID material, uint startingHealth,
+                              const MaterialRegistry &materials) {
+    this->recordMaterials(material, materials);
+    records.writeU8((uint8_t) JournalRecord::WALL);
+    this->recordTileMove(cord);
+    records.writeVarint(material);
+    records.writeVarint(startingHealth);
+}
+
+void DeltaJournal::recordDefaultTile(MaterialID floorMaterial, MaterialID wallMaterial,
+                                     const MaterialRegistry &materials) {
+    this->recordMaterials(std::max(floorMaterial, wallMaterial), materials);
+    records.writeU8((uint8_t) JournalRecord::DEFAULT_TILE);
+    records.writeVarint(floorMaterial);
+    records.writeVarint(wallMaterial);
+}
+
+// Finds the number of the object's type, recording its name the first time it is seen, and saves the
+//   object's state. If the type is not registered, recording stops and false is returned.
+template<class Object>
+bool DeltaJournal::recordType(JournalRecord record, std::unordered_map<const std::string *, uint> &typeNumbers,
+                              const std::string *typeName, Object &object, uint &typeNumber) {
+    if (!typeName) {
+        failure = std::string("An object's type is not registered: ") + typeid(object).name();
+        this->detach();
+        return false;
+    }
+
+    const auto found = typeNumbers.find(typeName);
+    if (found == typeNumbers.end()) {
+        typeNumber = (uint) typeNumbers.size();
+        typeNumbers[typeName] = typeNumber;
+        records.writeU8((uint8_t) record);
+        records.writeString(*typeName);
+    } else {
+        typeNumber = found->second;
+    }
+
+    state.bytes().clear();
+    object.saveState(state);
+    return true;
+}
+
+void DeltaJournal::recordAddEntity(EID id, const Coordinate &cord, Ientity &entity) {
+    uint typeNumber;
+    if (!this->recordType(JournalRecord::ENTITY_TYPE, entityTypeNumbers, registry->entityTypeName(entity), entity,
+                          typeNumber))
+        return;
+
+    // The slot may have held another entity, so its status is recorded in full at the end of the tick.
+    statusOfSlot(SlotMap<Ientity, EID>::slotIndexOf(id)).isKnown = false;
+    this->touchEntity(SlotMap<Ientity, EID>::slotIndexOf(id));
+
+    records.writeU8((uint8_t) JournalRecord::ADD_ENTITY);
+    records.writeVarint(id);
+    records.writeVarint(cord.x);
+    records.writeVarint(cord.y);
+    records.writeVarint(typeNumber);
+    records.writeVarint(state.size());
+    records.writeBytes(state.bytes().data(), state.size());
+}
+
+void DeltaJournal::recordMoveEntity(EID id, const Coordinate &from, const Coordinate &to) {
+    records.writeU8((uint8_t) JournalRecord::MOVE_ENTITY);
+    records.writeVarint(id);
+    records.writeSignedVarint((int64_t) to.x - from.x);
+    records.writeSignedVarint((int64_t) to.y - from.y);
+}
+
+void DeltaJournal::recordDeleteEntity(EID id) {
+    statusOfSlot(SlotMap<Ientity, EID>::slotIndexOf(id)).isKnown = false;
+    records.writeU8((uint8_t) JournalRecord::DELETE_ENTITY);
+    records.writeVarint(id);
+}
+
+void DeltaJournal::recordDamage(EID target, EID attacker, uint damageAmount, DamageType type) {
+    records.writeU8((uint8_t) JournalRecord::DAMAGE);
+    records.writeVarint(target);
+    records.writeVarint(attacker);
+    records.writeVarint(damageAmount);
+    records.writeVarint((uint) type);
+}
+
+void DeltaJournal::recordAddItem(IID id, const Coordinate &cord, Iitem &item) {
+    uint typeNumber;
+    if (!this->recordType(JournalRecord::ITEM_TYPE, itemTypeNumbers, registry->itemTypeName(item), item,
+                          typeNumber))
+        return;
+
+    records.writeU8((uint8_t) JournalRecord::ADD_ITEM);
+    records.writeVarint(id);
+    records.writeVarint(cord.x);
+    records.writeVarint(cord.y);
+    records.writeVarint(typeNumber);
+    records.writeVarint(state.size());
+    records.writeBytes(state.bytes().data(), state.size());
+}
+
+void DeltaJournal::recordDeleteItem(IID id) {
+    records.writeU8((uint8_t) JournalRecord::DELETE_ITEM);
+    records.writeVarint(id);
+}
+
+// Returns what was last recorded about the entity in the given slot, growing the list if needed.
+DeltaJournal::EntityStatus &DeltaJournal::statusOfSlot(uint slotIndex) {
+    if (slotIndex >= entityStatuses.size())
+        entityStatuses.resize(slotIndex + 1);
+    return entityStatuses[slotIndex];
+}
+
+// Notes that the entity in the given slot was ticked, damaged, or rescheduled, so it is checked for changes
+//   at the end of the tick. Called by World.
+void DeltaJournal::touchEntity(uint slotIndex) {
+    EntityStatus &status = statusOfSlot(slotIndex);
+    if (!status.isTouched) {
+        status.isTouched = true;
+        touchedSlots.push_back(slotIndex);
+    }
+}
+
+// Records the wake tick, last tick and state of every entity touched this tick that has changed since it
+//   was last recorded. The state is only written when it differs.
+void DeltaJournal::recordEntityStatuses() {
+    for (uint slotIndex : touchedSlots) {
+        EntityStatus &status = entityStatuses[slotIndex];
+        status.isTouched = false;
+
+        SlotMap<Ientity, EID>::Slot &slot = recordedWorld->entitiesInWorld.atSlot(slotIndex);
+        if (!slot.isOccupied)
+            continue;
+
+        state.bytes().clear();
+        slot.data.object().saveState(state);
+        const uint wakeTick = recordedWorld->entityWakeTick[slotIndex];
+        const uint lastTick = recordedWorld->entityLastTick[slotIndex];
+        const bool isStateChanged = !status.isKnown || (status.state != state.bytes());
+        if (status.isKnown && !isStateChanged && (status.wakeTick == wakeTick) && (status.lastTick == lastTick))
+            continue;
+
+        records.writeU8((uint8_t) JournalRecord::ENTITY_STATUS);
+        records.writeVarint(slot.data.id());
+        records.writeVarint((uint) (wakeTick + 1)); // TICK_NEVER is written as 0.
+        records.writeVarint(lastTick);
+        if (isStateChanged) {
+            records.writeVarint(state.size() + 1);
+            records.writeBytes(state.bytes().data(), state.size());
+            status.state = state.bytes();
+        } else {
+            records.writeVarint(0);
+        }
+
+        status.wakeTick = wakeTick;
+        status.lastTick = lastTick;
+        status.isKnown = true;
+    }
+    touchedSlots.clear();
+}
+
+// Marks the end of a tick. Called by World at the end of every tick.
+void DeltaJournal::endTick() {
+    this->recordEntityStatuses();
+    records.writeU8((uint8_t) JournalRecord::END_TICK);
+    if (records.size() >= JOURNAL_BLOCK_BYTES)
+        this->handOffRecords();
+}
+
+// Gives the records written so far to the writer thread, and starts a new buffer from a spare one.
+void DeltaJournal::handOffRecords() {
+    if (records.size() == 0)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingBlocks.emplace_back();
+        pendingBlocks.back().swap(records.bytes());
+        if (!spareBlocks.empty()) {
+            records.bytes().swap(spareBlocks.back());
+            spareBlocks.pop_back();
+        }
+    }
+    blocksChanged.notify_one();
+}
+
+// Writes blocks as they are handed off until the journal is stopped and every block is written.
+void DeltaJournal::writerLoop() {
+    std::vector<std::vector<uint8_t>> blocks;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (std::vector<uint8_t> &block : blocks) {
+                block.clear();
+                spareBlocks.push_back(std::move(block));
+            }
+            blocks.clear();
+
+            blocksChanged.wait(lock, [this] { return isStopping || !pendingBlocks.empty(); });
+            if (pendingBlocks.empty())
+                return;
+            blocks.swap(pendingBlocks);
+        }
+
+        bool isWritten = true;
+        for (const std::vector<uint8_t> &block : blocks)
+            isWritten = isWritten && (fwrite(block.data(), 1, block.size(), file) == block.size());
+        if (!isWritten) {
+            std::lock_guard<std::mutex> lock(mutex);
+            isWriteFailed = true;
+        }
+    }
+}
+
+// Opens the journal at the given path to replay onto the world, which must be loaded from the snapshot the
+//   journal started with. Returns true if successful. If not, the reason is stored in error, if it is given.
+bool JournalReplay::open(const std::string &path, World &world, const SnapshotRegistry &registry,
+                         std::string *error) {
+    this->world = nullptr;
+    entityTypes.clear();
+    itemTypes.clear();
+    lastTile = Coordinate{0, 0};
+    isTickCommitted = false;
+    failure.clear();
+
+    if (!file.open(path)) {
+        failure = "Could not open " + path;
+    } else {
+        reader = ByteReader(file.data(), file.size());
+        const uint8_t *magic = reader.readBytes(sizeof(JOURNAL_MAGIC));
+        const uint version = reader.readU32();
+        const uint startTick = reader.readU32();
+        const uint width = reader.readU32();
+        const uint height = reader.readU32();
+
+        if (!reader.isValid() || (memcmp(magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0))
+            failure = path + " is not a world journal";
+        else if (version != JOURNAL_VERSION)
+            failure = "The journal is of another version";
+        else if ((startTick != world.tickNumber) || (width != world.map->width()) ||
+                 (height != world.map->height()))
+            failure = "The world is not the one the journal started with";
+    }
+
+    if (!failure.empty()) {
+        file.close();
+        reader = ByteReader(nullptr, 0);
+        if (error)
+            *error = failure;
+        return false;
+    }
+
+    this->world = &world;
+    this->registry = &registry;
+    return true;
+}
+
+// Applies the changes of the next tick in the journal, and advances the world's tick number. Returns false
+//   at the end of the journal, or if the journal is not valid, in which case error says why. A tick that
+//   the journal ends partway through is left partly applied.
+bool JournalReplay::replayTick() {
+    if (!world || !failure.empty() || reader.isAtEnd())
+        return false;
+
+    while (!reader.isAtEnd()) {
+        const JournalRecord record = (JournalRecord) reader.readU8();
+        // The tick's changes wake the entities waiting near them before the statuses are restored, as
+        //   they did when the tick was recorded.
+        if (!isTickCommitted && ((record == JournalRecord::END_TICK) || (record == JournalRecord::ENTITY_STATUS))) {
+            world->wakeNearChangedChunks();
+            isTickCommitted = true;
+        }
+
+        if (record == JournalRecord::END_TICK) {
+            ++world->tickNumber;
+            isTickCommitted = false;
+            return true;
+        }
+
+        if (!this->applyRecord(record))
+            break;
+    }
+
+    if (!reader.isValid() || reader.isAtEnd())
+        failure = "The journal ends partway through tick " + std::to_string(world->tickNumber);
+    else if (failure.empty())
+        failure = "The journal is not valid at tick " + std::to_string(world->tickNumber);
+    return false;
+}
+
+// Replays ticks until the world reaches the given tick or the journal ends. Returns the number replayed.
+uint JournalReplay::replayUntil(uint tickNumber) {
+    uint nReplayed = 0;
+    while (world && (world->tickNumber < tickNumber) && this->replayTick())
+        nReplayed++;
+
+    return nReplayed;
+}
+
+// Reads a tile written as a change from the last tile. Returns false if it is outside the world.
+bool JournalReplay::readTileMove(Coordinate &cord) {
+    cord.x = (uint) ((int64_t) lastTile.x + reader.readSignedVarint());
+    cord.y = (uint) ((int64_t) lastTile.y + reader.readSignedVarint());
+    lastTile = cord;
+    return reader.isValid() && !cordOutsideBound(world->map->maxCord(), cord);
+}
+
+// Applies one record other than END_TICK. Returns false if it is not valid, or does not match the world.
+bool JournalReplay::applyRecord(JournalRecord record) {
+    TileMap &map = *world->map;
+
+    switch (record) {
+        case JournalRecord::MATERIAL: {
+            Material material{};
+            material.materialType = (MaterialType) reader.readVarint();
+            material.baseHealth = (uint) reader.readVarint();
+            material.color = (colorID) reader.readVarint();
+            material.defaultDisplayWall = (DisplayID) reader.readVarint();
+            material.defaultDisplayFloor = (DisplayID) reader.readVarint();
+            const uint nMaterials = map.materials.size();
+            return reader.isValid() && (map.materials.intern(material) == nMaterials);
+        }
+        case JournalRecord::FLOOR: {
+            Coordinate cord;
+            const bool isTileValid = this->readTileMove(cord);
+            const uint64_t material = reader.readVarint();
+            return isTileValid && reader.isValid() && (material < map.materials.size()) &&
+                   map.setFloorMaterial(cord, map.material((MaterialID) material));
+        }
+        case JournalRecord::WALL: {
+            Coordinate cord;
+            const bool isTileValid = this->readTileMove(cord);
+            const uint64_t material = reader.readVarint();
+            const uint startingHealth = (uint) reader.readVarint();
+            return isTileValid && reader.isValid() && (material < map.materials.size()) &&
+                   map.setWallMaterial(cord, map.material((MaterialID) material), startingHealth);
+        }
+        case JournalRecord::DEFAULT_TILE: {
+            const uint64_t floorMaterial = reader.readVarint();
+            const uint64_t wallMaterial = reader.readVarint();
+            return reader.isValid() && (floorMaterial < map.materials.size()) &&
+                   (wallMaterial < map.materials.size()) &&
+                   map.setDefaultTile(map.material((MaterialID) floorMaterial),
+                                      map.material((MaterialID) wallMaterial));
+        }
+        case JournalRecord::ENTITY_TYPE:
+            entityTypes.push_back(reader.readString());
+            return reader.isValid();
+        case JournalRecord::ITEM_TYPE:
+            itemTypes.push_back(reader.readString());
+            return reader.isValid();
+        case JournalRecord::ADD_ENTITY: {
+            const EID id = (EID) reader.readVarint();
+            const Coordinate cord = Coordinate{(uint) reader.readVarint(), (uint) reader.readVarint()};
+            const uint64_t typeNumber = reader.readVarint();
+            const uint64_t stateSize = reader.readVarint();
+            const uint8_t *state = reader.readBytes(stateSize);
+            if (!reader.isValid() || (typeNumber >= entityTypes.size()))
+                return false;
+
+            Ientity *entity = registry->createEntity(entityTypes[typeNumber]);
+            if (!entity) {
+                failure = "An entity type in the journal is not registered: " + entityTypes[typeNumber];
+                return false;
+            }
+
+            ByteReader stateReader(state, stateSize);
+            if (!entity->loadState(stateReader) || !stateReader.isValid() || !world->addEntity(entity, cord)) {
+                delete entity;
+                return false;
+            }
+
+            // The world gives out the same handles as it did when recording, unless it is not the same world.
+            const ObjectAndData<Ientity, EID> *added = world->getEntityOnTile(cord);
+            return added && (added->id() == id);
+        }
+        case JournalRecord::MOVE_ENTITY: {
+            const EID id = (EID) reader.readVarint();
+            const int64_t dx = reader.readSignedVarint();
+            const int64_t dy = reader.readSignedVarint();
+            SlotMap<Ientity, EID>::Slot *slot = world->entitiesInWorld.find(id);
+            if (!reader.isValid() || !slot)
+                return false;
+
+            const Coordinate &from = slot->data.coordinate();
+            const Coordinate to = Coordinate{(uint) ((int64_t) from.x + dx), (uint) ((int64_t) from.y + dy)};
+            return world->moveEntity(slot->data, to);
+        }
+        case JournalRecord::DELETE_ENTITY: {
+            const EID id = (EID) reader.readVarint();
+            return reader.isValid() && world->deleteEntity(id);
+        }
+        case JournalRecord::DAMAGE: {
+            const EID target = (EID) reader.readVarint();
+            const EID attacker = (EID) reader.readVarint();
+            const uint damageAmount = (uint) reader.readVarint();
+            const DamageType type = (DamageType) reader.readVarint();
+            SlotMap<Ientity, EID>::Slot *slot = world->entitiesInWorld.find(target);
+            if (!reader.isValid() || !slot)
+                return false;
+
+            // Only the entity's own response is replayed. Whatever it decided to do about it is in the journal.
+            slot->data.object().takeDamage(attacker, damageAmount, type);
+            return true;
+        }
+        case JournalRecord::ADD_ITEM: {
+            const IID id = (IID) reader.readVarint();
+            const Coordinate cord = Coordinate{(uint) reader.readVarint(), (uint) reader.readVarint()};
+            const uint64_t typeNumber = reader.readVarint();
+            const uint64_t stateSize = reader.readVarint();
+            const uint8_t *state = reader.readBytes(stateSize);
+            if (!reader.isValid() || (typeNumber >= itemTypes.size()))
+                return false;
+
+            Iitem *item = registry->createItem(itemTypes[typeNumber]);
+            if (!item) {
+                failure = "An item type in the journal is not registered: " + itemTypes[typeNumber];
+                return false;
+            }
+
+            ByteReader stateReader(state, stateSize);
+            if (!item->loadState(stateReader) || !stateReader.isValid() || !world->addItem(item, cord)) {
+                delete item;
+                return false;
+            }
+
+            // The item just added is first on its tile.
+            const uint slotIndex = world->firstItemOnTile.get(cord);
+            return world->itemsInWorld.atSlot(slotIndex).data.id() == id;
+        }
+        case JournalRecord::DELETE_ITEM: {
+            const IID id = (IID) reader.readVarint();
+            return reader.isValid() && world->deleteItem(id);
+        }
+        case JournalRecord::ENTITY_STATUS: {
+            const EID id = (EID) reader.readVarint();
+            const uint wakeTick = (uint) reader.readVarint() - 1;
+            const uint lastTick = (uint) reader.readVarint();
+            const uint64_t stateSize = reader.readVarint();
+            const uint8_t *state = (stateSize == 0) ? nullptr : reader.readBytes(stateSize - 1);
+            SlotMap<Ientity, EID>::Slot *slot = world->entitiesInWorld.find(id);
+            if (!reader.isValid() || !slot)
+                return false;
+
+            if (state) {
+                ByteReader stateReader(state, stateSize - 1);
+                if (!slot->data.object().loadState(stateReader) || !stateReader.isValid())
+                    return false;
+            }
+
+            // Only an entity waiting for a nearby change has no wake tick.
+            const uint slotIndex = SlotMap<Ientity, EID>::slotIndexOf(id);
+            world->entityLastTick[slotIndex] = lastTick;
+            world->scheduleEntity(slotIndex, wakeTick);
+            if (wakeTick == TICK_NEVER)
+                world->changeSleepersInChunks[world->getChunkNumberForCoordinate(slot->data.coordinate())]
+                        .push_back(id);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
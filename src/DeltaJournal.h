@@ -0,0 +1,173 @@
+#ifndef WELT_DELTAJOURNAL_H
+#define WELT_DELTAJOURNAL_H
+
+#include "WorldSnapshot.h"
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// The version of the journal format written by DeltaJournal. Bump it when the format changes.
+const uint JOURNAL_VERSION = 1;
+
+// The kinds of record in a journal. Each record is its kind as one byte, followed by its values as varints.
+enum class JournalRecord : uint8_t {
+    END_TICK,       // The changes of a tick are complete.
+    MATERIAL,       // A material was added to the TileMap's registry: type, base health, color, wall, floor.
+    FLOOR,          // x and y as a change from the last tile, material.
+    WALL,           // x and y as a change from the last tile, material, starting health.
+    DEFAULT_TILE,   // floor material, wall material.
+    ENTITY_TYPE,    // A name for the next entity type number, as a length and its characters.
+    ADD_ENTITY,     // EID, x, y, type number, state size, state.
+    MOVE_ENTITY,    // EID, x and y as a change from the entity's position.
+    DELETE_ENTITY,  // EID.
+    DAMAGE,         // target EID, attacker EID, amount, DamageType.
+    ITEM_TYPE,      // A name for the next item type number, as a length and its characters.
+    ADD_ITEM,       // IID, x, y, type number, state size, state.
+    DELETE_ITEM,    // IID.
+    ENTITY_STATUS   // EID, wake tick + 1, last tick, state size + 1 and state, or 0 if the state is unchanged.
+};
+
+// Records every change made to a World, tick by tick, so that a run can be played back exactly.
+//
+// A journal starts from a snapshot of the World saved when recording starts. From then on, the World and
+//   its TileMap report each change they make: tiles set with setFloorMaterial, setWallMaterial and
+//   setDefaultTile, entities added, moved, damaged and deleted, and items added and deleted. Each change
+//   is encoded as a short record of varints into a buffer, which is handed to a background thread to be
+//   written at the end of a tick once it is large enough, so recording never waits on the disk.
+//
+// Entities also change themselves when they are ticked or damaged. The World reports every entity whose
+//   schedule may have changed, and at the end of the tick the journal records the wake tick, last tick and
+//   state of each one that is not what it last recorded for it.
+//
+// Entities and items are recorded with their type names from a SnapshotRegistry and their saveState, so
+//   only registered types may be added while recording. Must not be started or stopped during a tick.
+class DeltaJournal {
+public:
+    DeltaJournal() = default;
+
+    ~DeltaJournal();
+
+    DeltaJournal(const DeltaJournal &) = delete;
+
+    DeltaJournal &operator=(const DeltaJournal &) = delete;
+
+    bool start(World &world, const std::string &path, const std::string &snapshotPath,
+               const SnapshotRegistry &registry, std::string *error = nullptr);
+
+    bool stop(std::string *error = nullptr);
+
+    bool isRecording() const { return recordedWorld != nullptr; }
+
+    // Called by TileMap and World as they make changes.
+
+    void recordFloor(const Coordinate &cord, MaterialID material, const MaterialRegistry &materials);
+
+    void recordWall(const Coordinate &cord, MaterialID material, uint startingHealth,
+                    const MaterialRegistry &materials);
+
+    void recordDefaultTile(MaterialID floorMaterial, MaterialID wallMaterial, const MaterialRegistry &materials);
+
+    void recordAddEntity(EID id, const Coordinate &cord, Ientity &entity);
+
+    void recordMoveEntity(EID id, const Coordinate &from, const Coordinate &to);
+
+    void recordDeleteEntity(EID id);
+
+    void recordDamage(EID target, EID attacker, uint damageAmount, DamageType type);
+
+    void recordAddItem(IID id, const Coordinate &cord, Iitem &item);
+
+    void recordDeleteItem(IID id);
+
+    void touchEntity(uint slotIndex);
+
+    void endTick();
+
+private:
+    // What the journal last recorded about the entity in a slot.
+    struct EntityStatus {
+        uint wakeTick = TICK_NEVER, lastTick = 0;
+        std::vector<uint8_t> state;
+        bool isKnown = false, isTouched = false;
+    };
+
+    World *recordedWorld = nullptr;
+    const SnapshotRegistry *registry = nullptr;
+    std::string failure; // Why recording failed, or empty.
+    ByteWriter records;  // Records not yet handed to the writer thread.
+    ByteWriter state;
+    Coordinate lastTile;
+    uint nKnownMaterials = 0;
+    std::unordered_map<const std::string *, uint> entityTypeNumbers, itemTypeNumbers;
+    std::vector<EntityStatus> entityStatuses; // By slot index.
+    std::vector<uint> touchedSlots;
+
+    FILE *file = nullptr;
+    std::thread writer;
+    std::mutex mutex; // Guards everything below.
+    std::condition_variable blocksChanged;
+    std::vector<std::vector<uint8_t>> pendingBlocks, spareBlocks;
+    bool isStopping = false, isWriteFailed = false;
+
+    void recordMaterials(MaterialID newestMaterial, const MaterialRegistry &materials);
+
+    void recordTileMove(const Coordinate &cord);
+
+    EntityStatus &statusOfSlot(uint slotIndex);
+
+    void recordEntityStatuses();
+
+    template<class Object>
+    bool recordType(JournalRecord record, std::unordered_map<const std::string *, uint> &typeNumbers,
+                    const std::string *typeName, Object &object, uint &typeNumber);
+
+    void handOffRecords();
+
+    void writerLoop();
+
+    void detach();
+};
+
+// Plays a journal written by DeltaJournal back onto a World, without ticking any entities. Only the changes
+//   in the journal are applied, so a replay runs much faster than the original simulation did.
+//
+// The World must be loaded from the snapshot the journal started with, and must not be ticked while it is
+//   replayed. Entities and items are created with the registry and loadState as they are added. The state
+//   and schedule an entity had at the end of each tick are restored, so a replayed world saves the same
+//   snapshot as the original did at that tick, and goes on to tick the same way.
+class JournalReplay {
+public:
+    bool open(const std::string &path, World &world, const SnapshotRegistry &registry,
+              std::string *error = nullptr);
+
+    bool replayTick();
+
+    uint replayUntil(uint tickNumber);
+
+    // Returns true once every complete tick in the journal has been replayed.
+    bool isAtEnd() const { return reader.isAtEnd(); }
+
+    // Returns why the last replay stopped early, or an empty string.
+    const std::string &error() const { return failure; }
+
+private:
+    MappedFile file;
+    ByteReader reader{nullptr, 0};
+    World *world = nullptr;
+    const SnapshotRegistry *registry = nullptr;
+    std::string failure;
+    std::vector<std::string> entityTypes, itemTypes;
+    Coordinate lastTile;
+    bool isTickCommitted = false; // Whether the changes of the tick being replayed have woken sleepers.
+
+    bool applyRecord(JournalRecord record);
+
+    bool readTileMove(Coordinate &cord);
+};
+
+
+#endif //WELT_DELTAJOURNAL_H
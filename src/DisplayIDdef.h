@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <algorithm>
 #include "../include/FlatVector.h"
 #include "universal.h"
 #include "../include/FlatVector.h"
@@ -22,6 +23,11 @@ struct DisplayArrayElement {
                         colorID foregroundColor) : BackgroundInfo(backgroundInfo), ForegroundInfo(foregroundInfo),
                                                    BackgroundColor(backgroundColor), ForegroundColor(foregroundColor) {}
 
+    bool operator==(const DisplayArrayElement &other) const {
+        return (BackgroundInfo == other.BackgroundInfo) && (ForegroundInfo == other.ForegroundInfo) &&
+               (BackgroundColor == other.BackgroundColor) && (ForegroundColor == other.ForegroundColor);
+    }
+
     DisplayID BackgroundInfo, ForegroundInfo;
     colorID BackgroundColor, ForegroundColor;
 };
@@ -34,6 +40,44 @@ struct DisplayArray {
     }
 };
 
+// A rectangle of tiles to be loaded into a DisplayArray, such as the part of the world a camera can see.
+struct ViewRect {
+    uint x, y;          // The tile at the top left corner.
+    uint width, height; // In tiles.
+};
+
+// Returns the part of the view that is inside a map of the given size.
+inline ViewRect clipViewRect(const ViewRect &view, uint mapWidth, uint mapHeight) {
+    ViewRect result = view;
+    result.x = std::min(view.x, mapWidth);
+    result.y = std::min(view.y, mapHeight);
+    result.width = std::min(view.width, mapWidth - result.x);
+    result.height = std::min(view.height, mapHeight - result.y);
+    return result;
+}
+
+// Returns true if the coordinate is inside the view.
+inline bool cordInsideView(const ViewRect &view, const Coordinate &cord) {
+    return (cord.x >= view.x) && (cord.y >= view.y) && (cord.x - view.x < view.width) &&
+           (cord.y - view.y < view.height);
+}
+
+// Returns the index in a DisplayArray of the view's size of a coordinate inside the view.
+inline uint getIndexInView(const ViewRect &view, const Coordinate &cord) {
+    return (cord.x - view.x) + ((cord.y - view.y) * view.width);
+}
+
+// Gives the DisplayArray the given dimensions, reallocating its data only if they change.
+inline void resizeDisplayArray(DisplayArray &displayArray, uint width, uint height) {
+    if ((displayArray.width == width) && (displayArray.height == height) && displayArray.displayData)
+        return;
+
+    delete[] displayArray.displayData;
+    displayArray.displayData = new DisplayArrayElement[(size_t) width * height];
+    displayArray.width = width;
+    displayArray.height = height;
+}
+
 // Contains all the displayIDs for every possible state of a tile. Used to allow for tiles to
 //   connect (like wall or fences) or other "fancy" effects.
 struct SpriteInteraction {
@@ -0,0 +1,179 @@
+#ifndef WELT_DISPLAYPYRAMID_H
+#define WELT_DISPLAYPYRAMID_H
+
+#include "universal.h"
+#include <algorithm>
+#include <vector>
+
+// Each cell of level 0 of an overview covers a square of (1 << OVERVIEW_BASE_BITS) tiles per side.
+//   Each cell of level n + 1 covers 2 by 2 cells of level n.
+const uint OVERVIEW_BASE_BITS = 3;
+
+// The number of entities in each cell of one level of an overview, row-major.
+struct DensityArray {
+    uint width, height;
+    std::vector<uint> counts;
+
+    DensityArray() : width(0), height(0) {}
+};
+
+// A mipmap-style pyramid of summaries of a grid of tiles, such as the dominant look of a region or the
+//   number of entities in it. Levels are stored row-major, and halve in size until a level has a single cell.
+// The owner writes level 0 through baseCell and marks what it wrote with markBaseChanged. refresh then
+//   recombines only the cells above the changed ones, so keeping the pyramid up to date costs
+//   O(changes * levels) rather than O(tiles).
+template<class Cell>
+class DisplayPyramid {
+public:
+    DisplayPyramid() = default;
+
+    void resize(uint tileWidth, uint tileHeight, const Cell &initialCell);
+
+    void clear();
+
+    // Returns true if the pyramid has been given a size.
+    bool isEmpty() const { return levels.empty(); }
+
+    uint levelCount() const { return (uint) levels.size(); }
+
+    uint levelWidth(uint level) const { return levels[level].width; }
+
+    uint levelHeight(uint level) const { return levels[level].height; }
+
+    // Returns the cells of a level, row-major.
+    const Cell *levelData(uint level) const { return levels[level].cells.data(); }
+
+    Cell &baseCell(uint x, uint y) { return levels[0].cells[(y * levels[0].width) + x]; }
+
+    void markBaseChanged(uint x, uint y);
+
+    void markAllChanged();
+
+    // Returns the row-major indices in level 0 of the cells marked since the last refresh.
+    const std::vector<uint> &changedBaseCells() const { return changedCells; }
+
+    template<class Combine>
+    void refresh(Combine &&combine);
+
+private:
+    struct Level {
+        uint width, height;
+        std::vector<Cell> cells;
+    };
+
+    template<class Combine>
+    void combineCell(uint level, uint x, uint y, Combine &combine);
+
+    std::vector<Level> levels;
+    std::vector<uint> changedCells;
+    std::vector<bool> isCellChanged;
+    bool isAllChanged = false;
+};
+
+// Sizes the pyramid to cover a grid of the given size in tiles, with every cell set to initialCell.
+template<class Cell>
+void DisplayPyramid<Cell>::resize(uint tileWidth, uint tileHeight, const Cell &initialCell) {
+    const uint cellSide = 1u << OVERVIEW_BASE_BITS;
+    uint width = (tileWidth + cellSide - 1) >> OVERVIEW_BASE_BITS;
+    uint height = (tileHeight + cellSide - 1) >> OVERVIEW_BASE_BITS;
+
+    levels.clear();
+    while (true) {
+        levels.push_back(Level{width, height, std::vector<Cell>((size_t) width * height, initialCell)});
+        if ((width == 1) && (height == 1))
+            break;
+
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+
+    changedCells.clear();
+    isCellChanged.assign(levels[0].cells.size(), false);
+    isAllChanged = false;
+}
+
+// Frees every level.
+template<class Cell>
+void DisplayPyramid<Cell>::clear() {
+    levels.clear();
+    changedCells.clear();
+    isCellChanged.clear();
+    isAllChanged = false;
+}
+
+// Records that a cell of level 0 has been, or is about to be, written.
+template<class Cell>
+void DisplayPyramid<Cell>::markBaseChanged(uint x, uint y) {
+    if (isAllChanged)
+        return;
+
+    const uint cellIndex = (y * levels[0].width) + x;
+    if (!isCellChanged[cellIndex]) {
+        isCellChanged[cellIndex] = true;
+        changedCells.push_back(cellIndex);
+    }
+}
+
+// Records that every cell of level 0 has changed. changedBaseCells then lists all of them.
+template<class Cell>
+void DisplayPyramid<Cell>::markAllChanged() {
+    if (isAllChanged)
+        return;
+
+    changedCells.resize(levels[0].cells.size());
+    for (uint i = 0; i < changedCells.size(); i++)
+        changedCells[i] = i;
+    isAllChanged = true;
+}
+
+// Recombines every cell above a changed cell of level 0. combine(const Cell *children, uint nChildren)
+//   returns the cell that summarises between one and four child cells.
+template<class Cell>
+template<class Combine>
+void DisplayPyramid<Cell>::refresh(Combine &&combine) {
+    if (changedCells.empty())
+        return;
+
+    // The changed cells of level 0 are forgotten first, so combine may mark new changes.
+    std::vector<uint> changed;
+    changed.swap(changedCells);
+    for (uint cellIndex : changed)
+        isCellChanged[cellIndex] = false;
+    isAllChanged = false;
+
+    // Turn the changed cells of a level into the changed cells of the level above, one level at a time.
+    //   A list of parents is sorted so that each parent is combined once.
+    std::vector<uint> parents;
+    for (uint level = 1; level < levels.size(); level++) {
+        const uint childWidth = levels[level - 1].width;
+        const uint width = levels[level].width;
+        parents.clear();
+        for (uint cellIndex : changed)
+            parents.push_back((((cellIndex / childWidth) / 2) * width) + ((cellIndex % childWidth) / 2));
+        std::sort(parents.begin(), parents.end());
+        parents.erase(std::unique(parents.begin(), parents.end()), parents.end());
+
+        for (uint cellIndex : parents)
+            this->combineCell(level, cellIndex % width, cellIndex / width, combine);
+
+        changed.swap(parents);
+    }
+}
+
+// Sets a cell of a level above 0 to the combination of the cells below it.
+template<class Cell>
+template<class Combine>
+void DisplayPyramid<Cell>::combineCell(uint level, uint x, uint y, Combine &combine) {
+    const Level &below = levels[level - 1];
+    Cell children[4];
+    uint nChildren = 0;
+
+    for (uint childY = y * 2; (childY < (y * 2) + 2) && (childY < below.height); childY++) {
+        for (uint childX = x * 2; (childX < (x * 2) + 2) && (childX < below.width); childX++)
+            children[nChildren++] = below.cells[(childY * below.width) + childX];
+    }
+
+    levels[level].cells[(y * levels[level].width) + x] = combine(children, nChildren);
+}
+
+#endif //WELT_DISPLAYPYRAMID_H
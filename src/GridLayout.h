@@ -0,0 +1,94 @@
+#ifndef WELT_GRIDLAYOUT_H
+#define WELT_GRIDLAYOUT_H
+
+#include "universal.h"
+
+// Layout policies decide where the cell at (x, y) of a 2D grid is stored in a flat array. They are
+//   used as template parameters, and by the World chunk grid through DefaultGridLayout.
+// A policy provides:
+//   indexInSquare(x, y, bits)           - index in a square grid of (1 << bits) cells per side.
+//   cellNumber(x, y, nColumns)          - index in a grid of any size with nColumns columns.
+//   cellCount(nColumns, nRows)          - size of the array needed for such a grid.
+//   cellCoordinates(n, nColumns, x, y)  - the inverse of cellNumber.
+//   LAYOUT_ID                           - a number that identifies the layout in saved files.
+
+// Stores rows one after another. Best for code that walks the grid a row at a time.
+struct RowMajorLayout {
+    static const uint LAYOUT_ID = 0;
+
+    static uint indexInSquare(uint x, uint y, uint bits) { return (y << bits) | x; }
+
+    static uint cellNumber(uint x, uint y, uint nColumns) { return (y * nColumns) + x; }
+
+    static uint cellCount(uint nColumns, uint nRows) { return nColumns * nRows; }
+
+    static void cellCoordinates(uint cellNumber, uint nColumns, uint &x, uint &y) {
+        x = cellNumber % nColumns;
+        y = cellNumber / nColumns;
+    }
+};
+
+// Spreads the low 16 bits of value out to the even bits of the result.
+inline uint spreadBits(uint value) {
+    value &= 0x0000FFFF;
+    value = (value | (value << 8)) & 0x00FF00FF;
+    value = (value | (value << 4)) & 0x0F0F0F0F;
+    value = (value | (value << 2)) & 0x33333333;
+    value = (value | (value << 1)) & 0x55555555;
+    return value;
+}
+
+// Gathers the even bits of value into the low 16 bits of the result.
+inline uint compactBits(uint value) {
+    value &= 0x55555555;
+    value = (value | (value >> 1)) & 0x33333333;
+    value = (value | (value >> 2)) & 0x0F0F0F0F;
+    value = (value | (value >> 4)) & 0x00FF00FF;
+    value = (value | (value >> 8)) & 0x0000FFFF;
+    return value;
+}
+
+// Stores cells in Z-order (Morton order), so that cells close together in 2D are usually close together
+//   in memory. Best for area queries and neighbour lookups. Grids that are not a square power of two are
+//   split into blocks of (1 << MORTON_BLOCK_BITS) cells per side, stored row-major, with Z-order inside
+//   each block, so padding is limited to the last row and column of blocks.
+const uint MORTON_BLOCK_BITS = 3;
+const uint MORTON_BLOCK_MASK = (1u << MORTON_BLOCK_BITS) - 1;
+
+struct MortonLayout {
+    static const uint LAYOUT_ID = 1;
+
+    // The Z-order index of a cell does not depend on the size of the square.
+    static uint indexInSquare(uint x, uint y, uint) { return spreadBits(x) | (spreadBits(y) << 1); }
+
+    static uint cellNumber(uint x, uint y, uint nColumns) {
+        const uint nBlockColumns = (nColumns + MORTON_BLOCK_MASK) >> MORTON_BLOCK_BITS;
+        const uint block = ((y >> MORTON_BLOCK_BITS) * nBlockColumns) + (x >> MORTON_BLOCK_BITS);
+        return (block << (2 * MORTON_BLOCK_BITS)) | indexInSquare(x & MORTON_BLOCK_MASK, y & MORTON_BLOCK_MASK,
+                                                                  MORTON_BLOCK_BITS);
+    }
+
+    static uint cellCount(uint nColumns, uint nRows) {
+        const uint nBlockColumns = (nColumns + MORTON_BLOCK_MASK) >> MORTON_BLOCK_BITS;
+        const uint nBlockRows = (nRows + MORTON_BLOCK_MASK) >> MORTON_BLOCK_BITS;
+        return (nBlockColumns * nBlockRows) << (2 * MORTON_BLOCK_BITS);
+    }
+
+    static void cellCoordinates(uint cellNumber, uint nColumns, uint &x, uint &y) {
+        const uint nBlockColumns = (nColumns + MORTON_BLOCK_MASK) >> MORTON_BLOCK_BITS;
+        const uint block = cellNumber >> (2 * MORTON_BLOCK_BITS);
+        const uint indexInBlock = cellNumber & ((1u << (2 * MORTON_BLOCK_BITS)) - 1);
+        x = ((block % nBlockColumns) << MORTON_BLOCK_BITS) | compactBits(indexInBlock);
+        y = ((block / nBlockColumns) << MORTON_BLOCK_BITS) | compactBits(indexInBlock >> 1);
+    }
+};
+
+// The layout used by TileMap and the World chunk grid. Define WELT_MORTON_LAYOUT to use Z-order.
+#ifdef WELT_MORTON_LAYOUT
+typedef MortonLayout DefaultGridLayout;
+#else
+typedef RowMajorLayout DefaultGridLayout;
+#endif
+
+
+#endif //WELT_GRIDLAYOUT_H
@@ -1,8 +1,6 @@
 #ifndef WELT_IOBJECTSEARCH_H
 #define WELT_IOBJECTSEARCH_H
 
-#include <vector>
-#include <list>
 #include "universal.h"
 #include "ObjectAndData.h"
 
@@ -11,8 +9,7 @@ using namespace std;
 template<class ObjectType, class ID_Type>
 class IObjectSearch {
 public:
-    explicit IObjectSearch(vector<list<ObjectAndData<ObjectType, ID_Type> *>*> chunks)
-            : _chunksReference(chunks) {
+    IObjectSearch() {
         _isAtEnd = true;
     }
 
@@ -33,7 +30,6 @@ public:
     };
 
 protected:
-    vector<list<ObjectAndData<ObjectType, ID_Type> *>*> _chunksReference;
     bool _isAtEnd;
 };
 
@@ -7,6 +7,7 @@
 #include "Iworld.h"
 #include "tile.h"
 #include "Iitem.h"
+#include "ByteStream.h"
 
 class Ientity {
 public:
@@ -17,8 +18,8 @@ public:
     virtual std::vector<std::size_t> getEntityTypeHash() = 0;
 
     virtual EffectedType
-    tick(Iworld<Ientity, EID ,Iitem, IID> *worldPointer, TileMap *map, const ObjectAndData<Ientity, EID> &selfReference,
-         uint energy) = 0;
+    tick(Iworld<Ientity, EID ,Iitem, IID> *worldPointer, const TileMap *map,
+         const ObjectAndData<Ientity, EID> &selfReference, uint energy) = 0;
 
     virtual EffectedType takeDamage(EID attacker, uint damageAmount, DamageType type) = 0;
 
@@ -29,6 +30,14 @@ public:
     virtual Material getMaterial() = 0;
 
     virtual DisplayID getDisplayID() = 0;
+
+    // Writes the state of the entity to a world snapshot. Entities with no state of their own write nothing.
+    virtual void saveState(ByteWriter &writer) {}
+
+    // Reads the state written by saveState into an entity just made by its snapshot factory, or into an
+    //   entity already in the world when a journal is replayed, so every part of the state must be set.
+    //   Returns false if the state is not valid.
+    virtual bool loadState(ByteReader &reader) { return true; }
 };
 
 #endif //IENTITY_H
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "universal.h"
 #include "material.h"
+#include "ByteStream.h"
 #include <typeinfo>
 #include <vector>
 
@@ -17,6 +18,13 @@ public:
     virtual Material getMaterial() = 0;
 
     virtual DisplayID getDisplayID() = 0;
+
+    // Writes the state of the item to a world snapshot. Items with no state of their own write nothing.
+    virtual void saveState(ByteWriter &writer) {}
+
+    // Reads the state written by saveState into an item just made by its snapshot factory.
+    //   Returns false if the state is not valid.
+    virtual bool loadState(ByteReader &reader) { return true; }
 };
 
 
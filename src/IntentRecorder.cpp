@@ -0,0 +1,180 @@
+#include "IntentRecorder.h"
+
+IntentRecorder::IntentRecorder(Iworld<Ientity, EID, Iitem, IID> *world, const TileMap *map)
+        : world(world), map(map), isSelfLocked(true),
+          self(nullptr, &isSelfLocked, true, 0, Coordinate()), selfChunk(0),
+          selfWakeTick(0) {
+}
+
+// Calls the given entity's tick function with the recorder standing in for the world. The chunk is the
+//   one the entity is in. If the entity asks to be deleted, a DELETE_SELF intent is recorded. Otherwise,
+//   the tick the entity wants to be ticked next is recorded, which is the next tick unless it went to sleep.
+EffectedType IntentRecorder::tickEntity(ObjectAndData<Ientity, EID> &entityData, uint energy, uint chunk) {
+    selfChunk = chunk;
+    selfWakeTick = world->getTickNumber() + 1;
+    self = ObjectAndData<Ientity, EID>(&entityData.object(), &isSelfLocked, false, entityData.id(),
+                                       entityData.coordinate());
+
+    const EffectedType returnState = self.object().tick(this, map, self, energy);
+
+    if (returnState == EffectedType::DELETED)
+        record(IntentType::DELETE_SELF);
+    else
+        recordedWakeRequests.push_back(WakeRequest{self.id(), selfWakeTick});
+
+    return returnState;
+}
+
+uint IntentRecorder::getTickNumber() {
+    return world->getTickNumber();
+}
+
+uint IntentRecorder::getEnergyPerTick() {
+    return world->getEnergyPerTick();
+}
+
+// Records a move with no passability check. Returns true if the destination looks free.
+bool IntentRecorder::moveEntity(const ObjectAndData<Ientity, EID> &entityData, Coordinate desiredPosition) {
+    return tryMove(entityData, desiredPosition, PASS_SOLID | PASS_GAS | PASS_LIQUID) == MoveResult::MOVED;
+}
+
+// Records a move of the entity being ticked if the destination looks passable and free, and updates
+//   the entity's own position so it can plan its next step from there.
+MoveResult IntentRecorder::tryMove(const ObjectAndData<Ientity, EID> &entityData, Coordinate desiredPosition,
+                                   PassabilityRule passabilityRule) {
+    if (cordOutsideBound(map->maxCord(), desiredPosition))
+        return MoveResult::OUTSIDE_WORLD;
+
+    // Only the entity being ticked may be moved.
+    if (!(entityData == self))
+        return MoveResult::NOT_FOUND;
+
+    if (!canPass(passabilityRule, map->wallMaterialAt(desiredPosition).materialType))
+        return MoveResult::BLOCKED;
+
+    ObjectAndData<Ientity, EID> *occupant = world->getEntityOnTile(desiredPosition);
+    if (occupant && (occupant->id() != self.id()))
+        return MoveResult::OCCUPIED;
+
+    Intent &intent = record(IntentType::MOVE);
+    intent.from = self.coordinate();
+    intent.to = desiredPosition;
+    intent.passabilityRule = passabilityRule;
+
+    isSelfLocked = false;
+    self.mutCoordinate() = desiredPosition;
+    isSelfLocked = true;
+
+    return MoveResult::MOVED;
+}
+
+// Records the addition of an entity. If World cannot add the entity, it will delete it.
+bool IntentRecorder::addEntity(Ientity *entityToAdd, Coordinate cord) {
+    if (cordOutsideBound(map->maxCord(), cord) || !entityToAdd || world->getEntityOnTile(cord))
+        return false;
+
+    Intent &intent = record(IntentType::ADD_ENTITY);
+    intent.to = cord;
+    intent.entity = entityToAdd;
+
+    return true;
+}
+
+// Records damage to an entity. The result is not known until the damage is applied, so NONE is returned.
+EffectedType IntentRecorder::damageEntity(EID target, EID attacker, uint damageAmount, DamageType type) {
+    Intent &intent = record(IntentType::DAMAGE);
+    intent.targetEntity = target;
+    intent.damageAmount = damageAmount;
+    intent.damageType = type;
+
+    return EffectedType::NONE;
+}
+
+// The world answers tile lookups from its occupancy layers, which are only read while entities are ticked.
+SearchResult<Ientity, EID, Iitem, IID>
+IntentRecorder::getObjectsOnTile(Coordinate cord, bool getEntities, bool getItems) {
+    return world->getObjectsOnTile(cord, getEntities, getItems);
+}
+
+// Searches through the recorder's own index views, so that queries made on different workers are counted apart.
+SearchResult<Ientity, EID, Iitem, IID>
+IntentRecorder::getObjectsInCircle(Coordinate circleCenter, uint radius, bool getEntities, bool getItems) {
+    SearchResult<Ientity, EID, Iitem, IID> result;
+
+    if (getEntities)
+        result.entitiesFound = std::make_shared<ObjectSearchCircle<Ientity, EID>>(this->entityIndex(), circleCenter,
+                                                                                 radius);
+
+    if (getItems)
+        result.itemsFound = std::make_shared<ObjectSearchCircle<Iitem, IID>>(this->itemIndex(), circleCenter, radius);
+
+    return result;
+}
+
+// Records the addition of an item. If World cannot add the item, it will delete it.
+bool IntentRecorder::addItem(Iitem *itemPtr, Coordinate cord) {
+    if (cordOutsideBound(map->maxCord(), cord) || !itemPtr)
+        return false;
+
+    Intent &intent = record(IntentType::ADD_ITEM);
+    intent.to = cord;
+    intent.item = itemPtr;
+
+    return true;
+}
+
+// Records the deletion of an item. Returns true if the item is in the world at the start of the tick.
+bool IntentRecorder::deleteItem(IID itemToDelete) {
+    if (!world->itemIndex().store->find(itemToDelete))
+        return false;
+
+    Intent &intent = record(IntentType::DELETE_ITEM);
+    intent.targetItem = itemToDelete;
+
+    return true;
+}
+
+ChunkIndexView<Ientity, EID> IntentRecorder::entityIndex() {
+    ChunkIndexView<Ientity, EID> view = world->entityIndex();
+    WELT_PROFILE_ONLY(view.queryCounters = &recordedQueries);
+
+    return view;
+}
+
+ChunkIndexView<Iitem, IID> IntentRecorder::itemIndex() {
+    ChunkIndexView<Iitem, IID> view = world->itemIndex();
+    WELT_PROFILE_ONLY(view.queryCounters = &recordedQueries);
+
+    return view;
+}
+
+uint IntentRecorder::getChunkPopulation(Coordinate cord, uint objectType) {
+    return world->getChunkPopulation(cord, objectType);
+}
+
+ObjectAndData<Ientity, EID> *IntentRecorder::getEntityOnTile(Coordinate cord) {
+    return world->getEntityOnTile(cord);
+}
+
+// Puts the entity being ticked to sleep until the given tick. Only the entity being ticked may sleep.
+void IntentRecorder::sleepUntil(const ObjectAndData<Ientity, EID> &entityData, uint wakeTick) {
+    if (entityData == self)
+        selfWakeTick = std::max(wakeTick, world->getTickNumber() + 1);
+}
+
+// Puts the entity being ticked to sleep until something changes near it.
+void IntentRecorder::sleepUntilNearbyChange(const ObjectAndData<Ientity, EID> &entityData) {
+    if (entityData == self)
+        selfWakeTick = TICK_NEVER;
+}
+
+// Appends a new intent from the entity being ticked and returns it.
+Intent &IntentRecorder::record(IntentType type) {
+    Intent intent = Intent();
+    intent.type = type;
+    intent.emitter = self.id();
+    intent.chunk = selfChunk;
+    recordedIntents.push_back(intent);
+
+    return recordedIntents.back();
+}
@@ -0,0 +1,119 @@
+#ifndef WELT_INTENTRECORDER_H
+#define WELT_INTENTRECORDER_H
+
+#include "universal.h"
+#include "material.h"
+#include "TileMap.h"
+#include "Iworld.h"
+#include "Ientity.h"
+#include "Iitem.h"
+#include "TimingWheel.h"
+#include "TickProfiler.h"
+#include "ObjectSearchCircle.h"
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+enum class IntentType {
+    MOVE,
+    DAMAGE,
+    ADD_ENTITY,
+    ADD_ITEM,
+    DELETE_ITEM,
+    DELETE_SELF
+};
+
+// A change to the world requested by an entity while it is being ticked.
+struct Intent {
+    IntentType type;
+    EID emitter;                     // The entity that requested the change.
+    uint chunk;                      // The chunk the emitter was in at the start of the tick.
+    Coordinate from, to;             // MOVE: the emitter's expected position and destination. ADD_*: the position.
+    PassabilityRule passabilityRule; // MOVE
+    EID targetEntity;                // DAMAGE
+    uint damageAmount;               // DAMAGE
+    DamageType damageType;           // DAMAGE
+    IID targetItem;                  // DELETE_ITEM
+    Ientity *entity;                 // ADD_ENTITY
+    Iitem *item;                     // ADD_ITEM
+};
+
+// The tick an entity asked to be ticked next, recorded for every entity that was ticked.
+struct WakeRequest {
+    EID entity;
+    uint wakeTick; // TICK_NEVER if the entity is waiting for a nearby change.
+};
+
+// Stands in for the world while entities decide what to do during a tick. Queries read the world
+//   as it was at the start of the tick, and every change is recorded as an Intent for World to apply later.
+// Moves are checked against the start of the tick and reported as successful if they look possible. The
+//   entity's own position is updated so it can plan several steps, but World may still reject the move.
+// While recording, an entity may only move itself, and must not change other objects directly. It is given
+//   the TileMap as const, so tiles can be read but not changed, and workers never allocate pages or record
+//   changed tiles at the same time.
+class IntentRecorder : public Iworld<Ientity, EID, Iitem, IID> {
+public:
+    IntentRecorder(Iworld<Ientity, EID, Iitem, IID> *world, const TileMap *map);
+
+    ~IntentRecorder() override = default;
+
+    EffectedType tickEntity(ObjectAndData<Ientity, EID> &entityData, uint energy, uint chunk);
+
+    vector<Intent> &intents() { return recordedIntents; }
+
+    vector<WakeRequest> &wakeRequests() { return recordedWakeRequests; }
+
+    // Returns the counts of the queries made through the recorder. Only counted if WELT_PROFILE is defined.
+    QueryCounters &queryCounters() { return recordedQueries; }
+
+    uint getTickNumber() override;
+
+    uint getEnergyPerTick() override;
+
+    bool moveEntity(const ObjectAndData<Ientity, EID> &entityData, Coordinate desiredPosition) override;
+
+    MoveResult tryMove(const ObjectAndData<Ientity, EID> &entityData, Coordinate desiredPosition,
+                       PassabilityRule passabilityRule) override;
+
+    bool addEntity(Ientity *entityToAdd, Coordinate cord) override;
+
+    EffectedType damageEntity(EID target, EID attacker, uint damageAmount, DamageType type) override;
+
+    SearchResult<Ientity, EID, Iitem, IID> getObjectsOnTile(Coordinate cord, bool getEntities, bool getItems) override;
+
+    SearchResult<Ientity, EID, Iitem, IID>
+    getObjectsInCircle(Coordinate circleCenter, uint radius, bool getEntities, bool getItems) override;
+
+    bool addItem(Iitem *itemPtr, Coordinate cord) override;
+
+    bool deleteItem(IID itemToDelete) override;
+
+    ChunkIndexView<Ientity, EID> entityIndex() override;
+
+    ChunkIndexView<Iitem, IID> itemIndex() override;
+
+    uint getChunkPopulation(Coordinate cord, uint objectType) override;
+
+    ObjectAndData<Ientity, EID> *getEntityOnTile(Coordinate cord) override;
+
+    void sleepUntil(const ObjectAndData<Ientity, EID> &entityData, uint wakeTick) override;
+
+    void sleepUntilNearbyChange(const ObjectAndData<Ientity, EID> &entityData) override;
+
+private:
+    Iworld<Ientity, EID, Iitem, IID> *world;
+    const TileMap *map; // Entities are only given the map to read. Every change goes through an Intent.
+    vector<Intent> recordedIntents;
+    vector<WakeRequest> recordedWakeRequests;
+    QueryCounters recordedQueries;
+    bool isSelfLocked;
+    ObjectAndData<Ientity, EID> self; // A copy of the data of the entity being ticked.
+    uint selfChunk;
+    uint selfWakeTick;
+
+    Intent &record(IntentType type);
+};
+
+
+#endif //WELT_INTENTRECORDER_H
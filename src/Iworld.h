@@ -2,8 +2,10 @@
 #define IWORLD_H
 
 #include "universal.h"
+#include "material.h"
 #include "ObjectAndData.h"
 #include "IObjectSearch.h"
+#include "ObjectQuery.h"
 #include <vector>
 #include <memory>
 #include <utility>
@@ -38,10 +40,18 @@ public:
 
     virtual uint getTickNumber() = 0;
 
+    virtual uint getEnergyPerTick() = 0;
+
     virtual bool moveEntity(const ObjectAndData<EntityType, EID> &entityData, Coordinate desiredPosition) = 0;
 
+    virtual MoveResult tryMove(const ObjectAndData<EntityType, EID> &entityData, Coordinate desiredPosition,
+                               PassabilityRule passabilityRule) = 0;
+
     virtual bool addEntity(EntityType *entityToAdd, Coordinate cord) = 0;
 
+    virtual EffectedType damageEntity(EntityID_Type target, EntityID_Type attacker, uint damageAmount,
+                                      DamageType type) = 0;
+
     virtual SearchResult<EntityType, EntityID_Type, ItemType, ItemID_Type>
     getObjectsOnTile(Coordinate cord, bool getEntities, bool getItems) = 0;
 
@@ -51,6 +61,59 @@ public:
     virtual bool addItem(ItemType *itemPtr, Coordinate cord) = 0;
 
     virtual bool deleteItem(IID itemToDelete) = 0;
+
+    virtual ChunkIndexView<EntityType, EntityID_Type> entityIndex() = 0;
+
+    virtual ChunkIndexView<ItemType, ItemID_Type> itemIndex() = 0;
+
+    virtual uint getChunkPopulation(Coordinate cord, uint objectType) = 0;
+
+    virtual ObjectAndData<EntityType, EntityID_Type> *getEntityOnTile(Coordinate cord) = 0;
+
+    // Stops ticking the entity until the given tick. When it is next ticked, it is given the energy for every
+    //   tick it slept through. An entity that knows it cannot act before then should call this from its tick.
+    virtual void sleepUntil(const ObjectAndData<EntityType, EntityID_Type> &entityData, uint wakeTick) = 0;
+
+    // Stops ticking the entity until something is added, deleted, or moved in its chunk or a neighbouring
+    //   chunk, or it is damaged.
+    virtual void sleepUntilNearbyChange(const ObjectAndData<EntityType, EntityID_Type> &entityData) = 0;
+
+    // Returns a range over the entities within the given radius of a point. Does not allocate.
+    CircleQuery<EntityType, EntityID_Type> entitiesInCircle(Coordinate circleCenter, uint radius) {
+        return CircleQuery<EntityType, EntityID_Type>(this->entityIndex(), circleCenter, radius);
+    }
+
+    // Returns a range over the entity on the given tile, if there is one. Does not allocate.
+    CircleQuery<EntityType, EntityID_Type> entitiesOnTile(Coordinate cord) {
+        return CircleQuery<EntityType, EntityID_Type>(this->entityIndex(), cord, 0);
+    }
+
+    // Returns up to k entities within maxRadius of center for which predicate(ObjectAndData<EntityType, EID> &)
+    //   returns true, nearest first. Only visits chunks that could hold something closer than what has been found.
+    template<class Predicate>
+    vector<ObjectAndData<EntityType, EntityID_Type>>
+    findNearest(Coordinate center, Predicate &&predicate, uint maxRadius, uint k = 1) {
+        return findNearestObjects(this->entityIndex(), center, std::forward<Predicate>(predicate), maxRadius, k);
+    }
+
+    // Same as findNearest, but only considers entities of the given object type. Chunks that hold no entities of
+    //   that type are skipped, and the predicate is only called for entities of that type.
+    template<class Predicate>
+    vector<ObjectAndData<EntityType, EntityID_Type>>
+    findNearestOfType(Coordinate center, uint objectType, Predicate &&predicate, uint maxRadius, uint k = 1) {
+        return findNearestObjects(this->entityIndex(), center, std::forward<Predicate>(predicate), maxRadius, k,
+                                  objectType);
+    }
+
+    // Returns a range over the items within the given radius of a point. Does not allocate.
+    CircleQuery<ItemType, ItemID_Type> itemsInCircle(Coordinate circleCenter, uint radius) {
+        return CircleQuery<ItemType, ItemID_Type>(this->itemIndex(), circleCenter, radius);
+    }
+
+    // Returns a range over the items on the given tile. Does not allocate.
+    CircleQuery<ItemType, ItemID_Type> itemsOnTile(Coordinate cord) {
+        return CircleQuery<ItemType, ItemID_Type>(this->itemIndex(), cord, 0);
+    }
 };
 
 #endif
\ No newline at end of file
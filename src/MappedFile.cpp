@@ -0,0 +1,69 @@
+#include "MappedFile.h"
+
+#include <cstdio>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define WELT_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    this->close();
+}
+
+// Maps the file at the given path, replacing any file already mapped. Returns true if successful.
+bool MappedFile::open(const std::string &path) {
+    this->close();
+
+#ifdef WELT_HAS_MMAP
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return false;
+
+    struct stat status{};
+    if ((fstat(descriptor, &status) != 0) || (status.st_size == 0)) {
+        ::close(descriptor);
+        return false;
+    }
+
+    void *mapping = mmap(nullptr, (size_t) status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+    ::close(descriptor);
+    if (mapping == MAP_FAILED)
+        return false;
+
+    fileData = (uint8_t *) mapping;
+    fileSize = (size_t) status.st_size;
+    isMapped = true;
+    return true;
+#else
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    uint8_t block[1 << 16];
+    size_t nRead;
+    while ((nRead = fread(block, 1, sizeof(block), file)) != 0)
+        readData.insert(readData.end(), block, block + nRead);
+    fclose(file);
+
+    fileData = readData.data();
+    fileSize = readData.size();
+    return fileSize != 0;
+#endif
+}
+
+// Unmaps the file. Pointers into it are no longer valid.
+void MappedFile::close() {
+#ifdef WELT_HAS_MMAP
+    if (isMapped)
+        munmap(fileData, fileSize);
+#endif
+    readData.clear();
+    readData.shrink_to_fit();
+    fileData = nullptr;
+    fileSize = 0;
+    isMapped = false;
+}
@@ -0,0 +1,38 @@
+#ifndef WELT_MAPPEDFILE_H
+#define WELT_MAPPEDFILE_H
+
+#include "universal.h"
+#include <string>
+#include <vector>
+
+// A whole file mapped into memory. The mapping is private and writable: the first write to a page of
+//   memory makes a copy of it, and the file itself is never changed. Pages of the file are only read from
+//   disk when they are first touched, so opening a large file is fast.
+// On systems without mmap, the file is read into memory instead.
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const std::string &path);
+
+    void close();
+
+    uint8_t *data() { return fileData; }
+
+    size_t size() const { return fileSize; }
+
+private:
+    uint8_t *fileData = nullptr;
+    size_t fileSize = 0;
+    bool isMapped = false;
+    std::vector<uint8_t> readData; // The contents of the file, if it could not be mapped.
+};
+
+
+#endif //WELT_MAPPEDFILE_H
@@ -0,0 +1,21 @@
+#include "MaterialRegistry.h"
+
+MaterialRegistry::MaterialRegistry() {
+    this->intern(M_AIR);
+}
+
+// Returns the ID of the given Material, registering it if it has not been seen before.
+// Worlds use a handful of materials, so a linear search is faster than hashing.
+//   If all 65536 IDs are in use, throws length_error.
+MaterialID MaterialRegistry::intern(const Material &material) {
+    for (uint i = 0; i < materials.size(); i++) {
+        if (materials[i] == material)
+            return (MaterialID) i;
+    }
+
+    if (materials.size() > UINT16_MAX)
+        throw std::length_error("MaterialRegistry is out of IDs");
+
+    materials.push_back(material);
+    return (MaterialID) (materials.size() - 1);
+}
@@ -0,0 +1,40 @@
+#ifndef WELT_MATERIALREGISTRY_H
+#define WELT_MATERIALREGISTRY_H
+
+#include "material.h"
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+// A small ID standing for a Material in a MaterialRegistry.
+typedef uint16_t MaterialID;
+
+// Interns Material definitions, so that tiles can store a 16 bit ID instead of a whole Material.
+//   Materials with the same fields share an ID. IDs are never freed.
+// M_AIR is always registered first, so the ID of air is always MATERIAL_ID_AIR.
+class MaterialRegistry {
+public:
+    MaterialRegistry();
+
+    MaterialID intern(const Material &material);
+
+    // Returns the Material with the given ID. The ID must have been given out by this registry.
+    const Material &get(MaterialID id) const { return materials[id]; }
+
+    // Returns the number of Materials in the registry.
+    uint size() const { return (uint) materials.size(); }
+
+private:
+    std::vector<Material> materials;
+};
+
+const MaterialID MATERIAL_ID_AIR = 0;
+
+// Returns true if the two Materials have the same fields.
+inline bool operator==(const Material &op1, const Material &op2) {
+    return (op1.materialType == op2.materialType) && (op1.baseHealth == op2.baseHealth) && (op1.color == op2.color) &&
+           (op1.defaultDisplayWall == op2.defaultDisplayWall) && (op1.defaultDisplayFloor == op2.defaultDisplayFloor);
+}
+
+
+#endif //WELT_MATERIALREGISTRY_H
@@ -0,0 +1,315 @@
+#ifndef WELT_OBJECTQUERY_H
+#define WELT_OBJECTQUERY_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "universal.h"
+#include "ObjectAndData.h"
+#include "SlotMap.h"
+#include "GridLayout.h"
+#include "TickProfiler.h"
+
+using namespace std;
+
+// Passed as the object type to queries that should not filter by type.
+const uint ANY_OBJECT_TYPE = 0xFFFFFFFF;
+
+// A non-owning view of a world's chunk index for one kind of object. Cheap to copy, so a
+//   world can hand one out per query.
+template<class ObjectType, class ID_Type>
+struct ChunkIndexView {
+    SlotMap<ObjectType, ID_Type> *store;
+    vector<vector<uint>> *chunks;
+    uint chunkSize, nChunksPerRow;
+    Coordinate maxCord;
+    vector<vector<uint>> *typeCounts; // Per chunk, the number of objects of each type. nullptr if not tracked.
+    vector<uint> *slotTypes;          // The object type of each slot. nullptr if not tracked.
+#ifdef WELT_PROFILE
+    QueryCounters *queryCounters;     // Where queries on the view are counted. nullptr if not counted.
+#endif
+
+    // Returns the chunk number of the chunk at the given chunk coordinate.
+    uint chunkNumber(uint chunkX, uint chunkY) const {
+        return DefaultGridLayout::cellNumber(chunkX, chunkY, nChunksPerRow);
+    }
+
+    // Returns false if it is known that the chunk holds no objects of the given type.
+    bool mayHoldType(uint chunk, uint objectType) const {
+        if (!typeCounts || (objectType == ANY_OBJECT_TYPE))
+            return true;
+
+        const vector<uint> &counts = (*typeCounts)[chunk];
+        return (objectType < counts.size()) && (counts[objectType] != 0);
+    }
+
+    // Returns false if it is known that the object in the given slot is not of the given type.
+    bool mayBeType(uint slotIndex, uint objectType) const {
+        return !slotTypes || (objectType == ANY_OBJECT_TYPE) || ((*slotTypes)[slotIndex] == objectType);
+    }
+};
+
+// A range over every object within the given radius of a point. Walks the world's chunk index
+//   directly, so building and iterating a query never allocates. Compatible with range-for:
+//
+//      for (auto &entityData : world->entitiesInCircle(center, radius)) { ... }
+//
+// The chunk index must not be structurally changed (objects added, moved, or deleted) while a query is iterated.
+template<class ObjectType, class ID_Type>
+class CircleQuery {
+public:
+    class iterator {
+    public:
+        iterator(const CircleQuery *query, bool isAtEnd) : _query(query), _chunkX(0), _chunkY(0),
+                                                           _position(0), _chunk(nullptr) {
+            if (isAtEnd)
+                return;
+
+            _chunkX = query->_chunkStart.x;
+            _chunkY = query->_chunkStart.y;
+            _chunk = &(*query->_index.chunks)[query->_index.chunkNumber(_chunkX, _chunkY)];
+            WELT_COUNT_QUERY(query->_index.queryCounters, chunksScanned, 1);
+            this->seek();
+        }
+
+        ObjectAndData<ObjectType, ID_Type> &operator*() const {
+            return _query->_index.store->atSlot((*_chunk)[_position]).data;
+        }
+
+        ObjectAndData<ObjectType, ID_Type> *operator->() const { return &(this->operator*()); }
+
+        iterator &operator++() {
+            ++_position;
+            this->seek();
+            return *this;
+        }
+
+        bool operator==(const iterator &other) const {
+            return (_chunk == other._chunk) && (_position == other._position);
+        }
+
+        bool operator!=(const iterator &other) const { return !(*this == other); }
+
+    private:
+        const CircleQuery *_query;
+        uint _chunkX, _chunkY, _position;
+        const vector<uint> *_chunk;
+
+        // Advances to the next object inside the circle, starting at the current position.
+        //   If there is none, becomes the end iterator.
+        void seek() {
+            const ChunkIndexView<ObjectType, ID_Type> &index = _query->_index;
+
+            while (true) {
+                for (; _position < _chunk->size(); ++_position) {
+                    WELT_COUNT_QUERY(index.queryCounters, candidatesTested, 1);
+                    if (distanceFast(_query->_center, index.store->atSlot((*_chunk)[_position]).data.coordinate(),
+                                     _query->_radius)) {
+                        WELT_COUNT_QUERY(index.queryCounters, candidatesAccepted, 1);
+                        return;
+                    }
+                }
+
+                // Move on to the next chunk in the rect, row by row.
+                _position = 0;
+                if (_chunkX != _query->_chunkEnd.x) {
+                    ++_chunkX;
+                } else if (_chunkY != _query->_chunkEnd.y) {
+                    _chunkX = _query->_chunkStart.x;
+                    ++_chunkY;
+                } else {
+                    _chunk = nullptr;
+                    return;
+                }
+
+                _chunk = &(*index.chunks)[index.chunkNumber(_chunkX, _chunkY)];
+                WELT_COUNT_QUERY(index.queryCounters, chunksScanned, 1);
+            }
+        }
+    };
+
+    CircleQuery(const ChunkIndexView<ObjectType, ID_Type> &index, Coordinate center, uint radius);
+
+    iterator begin() const { return iterator(this, _isEmpty); }
+
+    iterator end() const { return iterator(this, true); }
+
+    // Calls visitor(ObjectAndData<ObjectType, ID_Type> &) for every object in the circle.
+    template<class Visitor>
+    void forEach(Visitor &&visitor) const;
+
+    // Returns true if there are no objects in the circle.
+    bool empty() const { return begin() == end(); }
+
+private:
+    ChunkIndexView<ObjectType, ID_Type> _index;
+    Coordinate _center, _chunkStart, _chunkEnd;
+    uint _radius;
+    bool _isEmpty;
+};
+
+template<class ObjectType, class ID_Type>
+CircleQuery<ObjectType, ID_Type>::CircleQuery(const ChunkIndexView<ObjectType, ID_Type> &index,
+                                              Coordinate center, uint radius) : _index(index), _center(center),
+                                                                                _radius(radius) {
+    // If the center of the circle is outside the world, there is nothing to find.
+    _isEmpty = cordOutsideBound(index.maxCord, center);
+    if (_isEmpty)
+        return;
+
+    WELT_COUNT_QUERY(index.queryCounters, queries, 1);
+
+    // Find the bounding rect of the circle, clipped to the world, and the chunks it covers.
+    const Coordinate rectStart = Coordinate{(center.x < radius) ? 0 : center.x - radius,
+                                            (center.y < radius) ? 0 : center.y - radius};
+    const Coordinate rectEnd = Coordinate{((index.maxCord.x - center.x) < radius) ? index.maxCord.x : center.x + radius,
+                                          ((index.maxCord.y - center.y) < radius) ? index.maxCord.y : center.y + radius};
+
+    _chunkStart = Coordinate{rectStart.x / index.chunkSize, rectStart.y / index.chunkSize};
+    _chunkEnd = Coordinate{rectEnd.x / index.chunkSize, rectEnd.y / index.chunkSize};
+}
+
+template<class ObjectType, class ID_Type>
+template<class Visitor>
+void CircleQuery<ObjectType, ID_Type>::forEach(Visitor &&visitor) const {
+    if (_isEmpty)
+        return;
+
+    for (uint chunkY = _chunkStart.y; chunkY <= _chunkEnd.y; chunkY++) {
+        for (uint chunkX = _chunkStart.x; chunkX <= _chunkEnd.x; chunkX++) {
+            const vector<uint> &chunk = (*_index.chunks)[_index.chunkNumber(chunkX, chunkY)];
+            WELT_COUNT_QUERY(_index.queryCounters, chunksScanned, 1);
+            WELT_COUNT_QUERY(_index.queryCounters, candidatesTested, chunk.size());
+            for (const uint slotIndex : chunk) {
+                ObjectAndData<ObjectType, ID_Type> &objectData = _index.store->atSlot(slotIndex).data;
+                if (distanceFast(_center, objectData.coordinate(), _radius)) {
+                    WELT_COUNT_QUERY(_index.queryCounters, candidatesAccepted, 1);
+                    visitor(objectData);
+                }
+            }
+        }
+    }
+}
+
+// Returns the squared distance between two coordinates.
+inline unsigned long long distanceSquared(const Coordinate &c1, const Coordinate &c2) {
+    const long long dx = (long long) c1.x - (long long) c2.x;
+    const long long dy = (long long) c1.y - (long long) c2.y;
+    return (unsigned long long) ((dx * dx) + (dy * dy));
+}
+
+// Returns up to k objects of the given type within maxRadius of center that satisfy
+//   predicate(ObjectAndData<ObjectType, ID_Type> &), nearest first. Objects at the same distance are ordered by ID.
+// If the index tracks object types, chunks with no objects of the given type are skipped without touching
+//   their objects, and the predicate is only called for objects of the right type.
+// Chunks are visited in square rings around the chunk that holds the center. The search stops as soon as
+//   the closest unvisited tile is farther away than the k-th object found, so a nearby hit only costs a few chunks.
+template<class ObjectType, class ID_Type, class Predicate>
+vector<ObjectAndData<ObjectType, ID_Type>>
+findNearestObjects(const ChunkIndexView<ObjectType, ID_Type> &index, Coordinate center, Predicate &&predicate,
+                   uint maxRadius, uint k, uint objectType = ANY_OBJECT_TYPE) {
+    vector<ObjectAndData<ObjectType, ID_Type>> result;
+    if ((k == 0) || cordOutsideBound(index.maxCord, center))
+        return result;
+
+    WELT_COUNT_QUERY(index.queryCounters, queries, 1);
+
+    // The best k candidates found so far as (squared distance, ID, slot index), kept sorted.
+    vector<pair<pair<unsigned long long, ID_Type>, uint>> best;
+    best.reserve(k + 1);
+
+    const unsigned long long maxDistanceSqrd = (unsigned long long) maxRadius * maxRadius;
+    const long long chunkSize = index.chunkSize;
+    const long long centerChunkX = center.x / index.chunkSize;
+    const long long centerChunkY = center.y / index.chunkSize;
+    const long long lastChunkX = index.maxCord.x / index.chunkSize;
+    const long long lastChunkY = index.maxCord.y / index.chunkSize;
+
+    // Checks every object in a chunk against the predicate and the current best candidates.
+    auto scanChunk = [&](long long chunkX, long long chunkY) {
+        const uint chunk = index.chunkNumber((uint) chunkX, (uint) chunkY);
+        if (!index.mayHoldType(chunk, objectType))
+            return;
+
+        WELT_COUNT_QUERY(index.queryCounters, chunksScanned, 1);
+        for (const uint slotIndex : (*index.chunks)[chunk]) {
+            if (!index.mayBeType(slotIndex, objectType))
+                continue;
+
+            WELT_COUNT_QUERY(index.queryCounters, candidatesTested, 1);
+
+            ObjectAndData<ObjectType, ID_Type> &objectData = index.store->atSlot(slotIndex).data;
+            const unsigned long long distanceSqrd = distanceSquared(center, objectData.coordinate());
+            if (distanceSqrd > maxDistanceSqrd)
+                continue;
+
+            const pair<unsigned long long, ID_Type> key = make_pair(distanceSqrd, objectData.id());
+            if ((best.size() == k) && !(key < best.back().first))
+                continue;
+
+            if (!predicate(objectData))
+                continue;
+
+            WELT_COUNT_QUERY(index.queryCounters, candidatesAccepted, 1);
+
+            const auto position = upper_bound(best.begin(), best.end(), make_pair(key, 0u),
+                                              [](const pair<pair<unsigned long long, ID_Type>, uint> &a,
+                                                 const pair<pair<unsigned long long, ID_Type>, uint> &b) {
+                                                  return a.first < b.first;
+                                              });
+            best.insert(position, make_pair(key, slotIndex));
+            if (best.size() > k)
+                best.pop_back();
+        }
+    };
+
+    for (long long ring = 0;; ring++) {
+        const long long startX = max(centerChunkX - ring, 0LL), endX = min(centerChunkX + ring, lastChunkX);
+        const long long startY = max(centerChunkY - ring, 0LL), endY = min(centerChunkY + ring, lastChunkY);
+
+        // Visit the chunks on the edge of the ring that are inside the world.
+        for (long long chunkY = startY; chunkY <= endY; chunkY++) {
+            if ((chunkY == (centerChunkY - ring)) || (chunkY == (centerChunkY + ring))) {
+                for (long long chunkX = startX; chunkX <= endX; chunkX++)
+                    scanChunk(chunkX, chunkY);
+            } else {
+                if ((centerChunkX - ring) >= 0)
+                    scanChunk(centerChunkX - ring, chunkY);
+                if ((centerChunkX + ring) <= lastChunkX)
+                    scanChunk(centerChunkX + ring, chunkY);
+            }
+        }
+
+        // Find the distance from the center to the closest tile that has not been visited yet. Only
+        //   sides of the visited area that do not touch the edge of the world have tiles beyond them.
+        long long closestUnvisited = -1;
+        auto considerSide = [&closestUnvisited](bool hasTilesBeyond, long long gap) {
+            if (hasTilesBeyond && ((closestUnvisited < 0) || (gap < closestUnvisited)))
+                closestUnvisited = gap;
+        };
+        considerSide((centerChunkX - ring) > 0, (long long) center.x - ((centerChunkX - ring) * chunkSize) + 1);
+        considerSide((centerChunkX + ring) < lastChunkX, ((centerChunkX + ring + 1) * chunkSize) - (long long) center.x);
+        considerSide((centerChunkY - ring) > 0, (long long) center.y - ((centerChunkY - ring) * chunkSize) + 1);
+        considerSide((centerChunkY + ring) < lastChunkY, ((centerChunkY + ring + 1) * chunkSize) - (long long) center.y);
+
+        // Stop if every chunk was visited, if everything unvisited is out of range, or if nothing
+        //   unvisited could be closer than the k-th candidate.
+        if (closestUnvisited < 0)
+            break;
+
+        const unsigned long long closestUnvisitedSqrd = (unsigned long long) (closestUnvisited * closestUnvisited);
+        if (closestUnvisitedSqrd > maxDistanceSqrd)
+            break;
+
+        if ((best.size() == k) && (best.back().first.first < closestUnvisitedSqrd))
+            break;
+    }
+
+    result.reserve(best.size());
+    for (const auto &candidate : best)
+        result.push_back(index.store->atSlot(candidate.second).data);
+
+    return result;
+}
+
+#endif //WELT_OBJECTQUERY_H
@@ -2,19 +2,18 @@
 #define WELT_OBJECTSEARCHCIRCLE_H
 
 
-#include <vector>
-#include <list>
 #include "universal.h"
 #include "IObjectSearch.h"
 #include "ObjectAndData.h"
+#include "ObjectQuery.h"
 
 using namespace std;
 
+// Adapts a CircleQuery to the IObjectSearch interface.
 template<class ObjectType, class ID_Type>
 class ObjectSearchCircle : public IObjectSearch<ObjectType, ID_Type> {
 public:
-    explicit ObjectSearchCircle(vector<list<ObjectAndData<ObjectType, ID_Type> *> *> chunksReference,
-                                Coordinate center, uint radius);
+    explicit ObjectSearchCircle(const ChunkIndexView<ObjectType, ID_Type> &index, Coordinate center, uint radius);
 
     virtual ~ObjectSearchCircle() = default;
 
@@ -29,46 +28,15 @@ public:
     ObjectAndData<ObjectType, ID_Type> ObjectAndDataCopy() const override;
 
 protected:
-    uint _radius;
-    Coordinate _center;
-    typename vector<list<ObjectAndData<ObjectType, ID_Type> *> *>::iterator _chunksIterator;
-    typename list<ObjectAndData<ObjectType, ID_Type> *>::iterator _objectIterator;
-
-
+    CircleQuery<ObjectType, ID_Type> _query;
+    typename CircleQuery<ObjectType, ID_Type>::iterator _objectIterator;
 };
 
 template<class ObjectType, class ID_Type>
-ObjectSearchCircle<ObjectType, ID_Type>::ObjectSearchCircle(
-        vector<list<ObjectAndData<ObjectType, ID_Type> *> *> chunksReference, Coordinate center,
-        uint radius) : IObjectSearch<ObjectType, ID_Type>(chunksReference), _center(center),
-                       _radius(radius) {
-    this->_isAtEnd = true;
-
-    if (this->_chunksReference.size() == 0)
-        return;
-
-    bool foundViableEntity = false;
-    _chunksIterator = this->_chunksReference.begin();
-    while (_chunksIterator != this->_chunksReference.end()) {
-        if ((**_chunksIterator).size() == 0) {
-            _chunksIterator++;
-            continue;
-        } else {
-            _objectIterator = (**_chunksIterator).begin();
-            while (_objectIterator != (**_chunksIterator).end()) {
-                if (distanceFast(this->_center, (*_objectIterator)->coordinate(), _radius)) {
-                    foundViableEntity = true;
-                    break;
-                }
-                _objectIterator++;
-            }
-            if (foundViableEntity) {
-                this->_isAtEnd = false;
-                break;
-            }
-        }
-        _chunksIterator++;
-    }
+ObjectSearchCircle<ObjectType, ID_Type>::ObjectSearchCircle(const ChunkIndexView<ObjectType, ID_Type> &index,
+                                                            Coordinate center, uint radius)
+        : _query(index, center, radius), _objectIterator(_query.begin()) {
+    this->_isAtEnd = (_objectIterator == _query.end());
 }
 
 template<class ObjectType, class ID_Type>
@@ -76,51 +44,28 @@ void ObjectSearchCircle<ObjectType, ID_Type>::next() {
     if (this->_isAtEnd)
         throw std::out_of_range("oof"); //TODO: Add custom exception class instead of "oof."
 
-    _objectIterator++;
-    while (!this->_isAtEnd) {
-        if (_objectIterator == (**_chunksIterator).end()) {
-            _chunksIterator++;
-            while (_chunksIterator != this->_chunksReference.end()) {
-                if ((**_chunksIterator).size() == 0) {
-                    _chunksIterator++;
-                    continue;
-                }
-
-                _objectIterator = (**_chunksIterator).begin();
-                break;
-            }
-
-            if (_chunksIterator == this->_chunksReference.end()) {
-                this->_isAtEnd = true;
-            }
-        }
-
-        if ((this->_isAtEnd) || (distanceFast(this->_center, (*_objectIterator)->coordinate(), _radius)))
-            break;
-        else
-            _objectIterator++;
-    }
-
+    ++_objectIterator;
+    this->_isAtEnd = (_objectIterator == _query.end());
 }
 
 template<class ObjectType, class ID_Type>
 ID_Type ObjectSearchCircle<ObjectType, ID_Type>::id() const {
-    return (*_objectIterator)->id();
+    return _objectIterator->id();
 }
 
 template<class ObjectType, class ID_Type>
 Coordinate ObjectSearchCircle<ObjectType, ID_Type>::position() const {
-    return (*_objectIterator)->coordinate();
+    return _objectIterator->coordinate();
 }
 
 template<class ObjectType, class ID_Type>
 ObjectType &ObjectSearchCircle<ObjectType, ID_Type>::object() {
-    return (*_objectIterator)->object();
+    return _objectIterator->object();
 }
 
 template<class ObjectType, class ID_Type>
 ObjectAndData<ObjectType, ID_Type> ObjectSearchCircle<ObjectType, ID_Type>::ObjectAndDataCopy() const {
-    return **_objectIterator;
+    return *_objectIterator;
 }
 
 #endif //WELT_OBJECTSEARCHCIRCLE_H
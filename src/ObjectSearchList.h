@@ -0,0 +1,75 @@
+#ifndef WELT_OBJECTSEARCHLIST_H
+#define WELT_OBJECTSEARCHLIST_H
+
+
+#include "universal.h"
+#include "IObjectSearch.h"
+#include "ObjectAndData.h"
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+// Adapts a list of objects that were already found to the IObjectSearch interface.
+//   Used when the objects can be looked up directly, such as the objects on a single tile.
+template<class ObjectType, class ID_Type>
+class ObjectSearchList : public IObjectSearch<ObjectType, ID_Type> {
+public:
+    ObjectSearchList() = default;
+
+    virtual ~ObjectSearchList() = default;
+
+    // Adds an object to the end of the list.
+    void add(const ObjectAndData<ObjectType, ID_Type> &objectData);
+
+    void next() override;
+
+    ID_Type id() const override;
+
+    Coordinate position() const override;
+
+    ObjectType &object() override;
+
+    ObjectAndData<ObjectType, ID_Type> ObjectAndDataCopy() const override;
+
+protected:
+    vector<ObjectAndData<ObjectType, ID_Type>> _objects;
+    size_t _position = 0;
+};
+
+template<class ObjectType, class ID_Type>
+void ObjectSearchList<ObjectType, ID_Type>::add(const ObjectAndData<ObjectType, ID_Type> &objectData) {
+    _objects.push_back(objectData);
+    this->_isAtEnd = (_position >= _objects.size());
+}
+
+template<class ObjectType, class ID_Type>
+void ObjectSearchList<ObjectType, ID_Type>::next() {
+    if (this->_isAtEnd)
+        throw std::out_of_range("oof"); //TODO: Add custom exception class instead of "oof."
+
+    _position++;
+    this->_isAtEnd = (_position >= _objects.size());
+}
+
+template<class ObjectType, class ID_Type>
+ID_Type ObjectSearchList<ObjectType, ID_Type>::id() const {
+    return _objects[_position].id();
+}
+
+template<class ObjectType, class ID_Type>
+Coordinate ObjectSearchList<ObjectType, ID_Type>::position() const {
+    return _objects[_position].coordinate();
+}
+
+template<class ObjectType, class ID_Type>
+ObjectType &ObjectSearchList<ObjectType, ID_Type>::object() {
+    return _objects[_position].object();
+}
+
+template<class ObjectType, class ID_Type>
+ObjectAndData<ObjectType, ID_Type> ObjectSearchList<ObjectType, ID_Type>::ObjectAndDataCopy() const {
+    return _objects[_position];
+}
+
+#endif //WELT_OBJECTSEARCHLIST_H
@@ -0,0 +1,207 @@
+#ifndef WELT_SLOTMAP_H
+#define WELT_SLOTMAP_H
+
+#include <vector>
+#include <stdexcept>
+#include "universal.h"
+#include "ObjectAndData.h"
+
+// Handles given out by a SlotMap store the slot index in their low bits and the
+//   slot's generation in their high bits. The generation is bumped every time a slot is
+//   freed, so a handle to a deleted object will never resolve to the object that reuses its slot.
+// A slot whose generation cannot be bumped any further is retired instead of being freed, so
+//   generations never wrap around and no handle is ever given out twice. Each slot can hold
+//   (1 << (32 - SLOT_INDEX_BITS)) objects over its life, so a SlotMap can hold about four billion
+//   objects in total before insert throws length_error.
+const uint SLOT_INDEX_BITS = 22;
+const uint SLOT_INDEX_MASK = (1u << SLOT_INDEX_BITS) - 1;
+const uint SLOT_GENERATION_MASK = (1u << (32 - SLOT_INDEX_BITS)) - 1;
+
+// Marks the absence of a slot in slot index arrays.
+const uint SLOT_NONE = 0xFFFFFFFF;
+
+// Slots are allocated in pages of (1 << SLOT_PAGE_BITS) slots.
+const uint SLOT_PAGE_BITS = 10;
+const uint SLOT_PAGE_MASK = (1u << SLOT_PAGE_BITS) - 1;
+
+// Stores objects in reusable slots addressed by generational handles. Lookup, insertion,
+//   and deletion are all O(1). Occupied slots are also kept in a dense array so they can be
+//   iterated without skipping holes. Slots are allocated in fixed size pages that are never
+//   reallocated, so references to a slot's data stay valid while other objects are inserted or erased.
+template<class Object, class ID_Type>
+class SlotMap {
+public:
+    struct Slot {
+        Slot(Object *pointer, bool *lockPointer, Coordinate position) :
+                data(pointer, lockPointer, false, 0, position), denseIndex(0), chunkPosition(0),
+                generation(0), isOccupied(false) {}
+
+        ObjectAndData<Object, ID_Type> data;
+        uint denseIndex;    // Position of the slot in the dense array.
+        uint chunkPosition; // Position of the slot in its chunk's index. Maintained by the owner of the SlotMap.
+        uint generation;
+        bool isOccupied;
+    };
+
+    SlotMap() = default;
+
+    ~SlotMap() = default;
+
+    ID_Type insert(Object *pointer, bool *lockPointer, Coordinate position);
+
+    ID_Type insertAt(uint slotIndex, Object *pointer, bool *lockPointer, Coordinate position);
+
+    bool erase(ID_Type id);
+
+    Slot *find(ID_Type id);
+
+    // Returns the slot with the given index. The index must be of an occupied slot.
+    Slot &atSlot(uint slotIndex) { return pages[slotIndex >> SLOT_PAGE_BITS][slotIndex & SLOT_PAGE_MASK]; }
+
+    // Returns the slot index of the nth object in the dense array.
+    uint denseSlot(uint denseIndex) const { return dense[denseIndex]; }
+
+    // Returns the number of objects in the SlotMap.
+    uint size() const { return (uint) dense.size(); }
+
+    // Returns the number of slots, occupied or free.
+    uint slotCount() const { return nSlots; }
+
+    // Returns the free slots, in the order they will be reused from the back.
+    const std::vector<uint> &freeSlotList() const { return freeSlots; }
+
+    // Returns true if the slot with the given index has used up its generations and will never be reused.
+    //   Retired slots are never in the free list.
+    bool isRetired(uint slotIndex) {
+        const Slot &slot = atSlot(slotIndex);
+        return !slot.isOccupied && (slot.generation == SLOT_GENERATION_MASK);
+    }
+
+    void restoreSlots(const std::vector<uint> &generations, const std::vector<uint> &freeSlotList);
+
+    // Returns the slot index encoded in the given handle.
+    static uint slotIndexOf(ID_Type id) { return id & SLOT_INDEX_MASK; }
+
+private:
+    std::vector<std::vector<Slot>> pages;
+    std::vector<uint> dense;
+    uint nSlots = 0;
+    std::vector<uint> freeSlots;
+
+    void appendSlot();
+
+    ID_Type occupy(uint slotIndex, Object *pointer, bool *lockPointer, Coordinate position);
+};
+
+// Stores the object in a free slot and returns the handle for it.
+template<class Object, class ID_Type>
+ID_Type SlotMap<Object, ID_Type>::insert(Object *pointer, bool *lockPointer, Coordinate position) {
+    uint slotIndex;
+
+    // Reuse a freed slot if one is available. If not, create a new slot.
+    if (!freeSlots.empty()) {
+        slotIndex = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slotIndex = nSlots;
+        this->appendSlot();
+    }
+
+    return this->occupy(slotIndex, pointer, lockPointer, position);
+}
+
+// Stores the object in the given slot, which must exist, be free, and not be in the free list. Used to
+//   rebuild a SlotMap with the same handles as before, after restoreSlots.
+template<class Object, class ID_Type>
+ID_Type SlotMap<Object, ID_Type>::insertAt(uint slotIndex, Object *pointer, bool *lockPointer, Coordinate position) {
+    if ((slotIndex >= nSlots) || atSlot(slotIndex).isOccupied)
+        throw std::invalid_argument("SlotMap slot is missing or occupied");
+
+    return this->occupy(slotIndex, pointer, lockPointer, position);
+}
+
+// Makes an empty SlotMap have a free slot for every given generation, and the given free list. Slots that
+//   are not in the free list are left for insertAt, or stay retired if they are at their last generation.
+template<class Object, class ID_Type>
+void SlotMap<Object, ID_Type>::restoreSlots(const std::vector<uint> &generations,
+                                            const std::vector<uint> &freeSlotList) {
+    if ((nSlots != 0) || (generations.size() > (size_t) SLOT_INDEX_MASK + 1))
+        throw std::invalid_argument("SlotMap slots can only be restored into an empty SlotMap");
+
+    for (uint generation : generations) {
+        this->appendSlot();
+        atSlot(nSlots - 1).generation = generation & SLOT_GENERATION_MASK;
+    }
+    freeSlots = freeSlotList;
+}
+
+// Adds a free slot at the end. Pages are reserved up front so they never reallocate.
+template<class Object, class ID_Type>
+void SlotMap<Object, ID_Type>::appendSlot() {
+    if (nSlots > SLOT_INDEX_MASK)
+        throw std::length_error("SlotMap is out of slots");
+
+    if ((nSlots & SLOT_PAGE_MASK) == 0) {
+        pages.emplace_back();
+        pages.back().reserve(SLOT_PAGE_MASK + 1);
+    }
+
+    pages.back().emplace_back(nullptr, nullptr, Coordinate());
+    nSlots++;
+}
+
+// Puts the object in the given free slot and returns the handle for it.
+template<class Object, class ID_Type>
+ID_Type SlotMap<Object, ID_Type>::occupy(uint slotIndex, Object *pointer, bool *lockPointer, Coordinate position) {
+    Slot &slot = atSlot(slotIndex);
+    const ID_Type id = (slot.generation << SLOT_INDEX_BITS) | slotIndex;
+    slot.data = ObjectAndData<Object, ID_Type>(pointer, lockPointer, false, id, position);
+    slot.denseIndex = (uint) dense.size();
+    slot.chunkPosition = 0;
+    slot.isOccupied = true;
+    dense.push_back(slotIndex);
+
+    return id;
+}
+
+// Frees the slot referenced by the given handle. The object itself is not deleted.
+// Returns false if the handle does not reference an occupied slot.
+template<class Object, class ID_Type>
+bool SlotMap<Object, ID_Type>::erase(ID_Type id) {
+    Slot *slot = this->find(id);
+    if (!slot)
+        return false;
+
+    // Swap the last element of the dense array into the freed position.
+    const uint lastSlotIndex = dense.back();
+    dense[slot->denseIndex] = lastSlotIndex;
+    atSlot(lastSlotIndex).denseIndex = slot->denseIndex;
+    dense.pop_back();
+
+    slot->isOccupied = false;
+
+    // Retire the slot rather than let its generation wrap back to one that was given out before.
+    if (slot->generation == SLOT_GENERATION_MASK)
+        return true;
+
+    slot->generation++;
+    freeSlots.push_back(slotIndexOf(id));
+
+    return true;
+}
+
+// Returns the slot referenced by the given handle, or nullptr if the handle is stale or invalid.
+template<class Object, class ID_Type>
+typename SlotMap<Object, ID_Type>::Slot *SlotMap<Object, ID_Type>::find(ID_Type id) {
+    const uint slotIndex = slotIndexOf(id);
+    if (slotIndex >= nSlots)
+        return nullptr;
+
+    Slot &slot = atSlot(slotIndex);
+    if (!slot.isOccupied || (slot.data.id() != id))
+        return nullptr;
+
+    return &slot;
+}
+
+#endif //WELT_SLOTMAP_H
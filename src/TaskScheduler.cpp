@@ -0,0 +1,166 @@
+#include "TaskScheduler.h"
+#include "TraceWriter.h"
+
+// Creates a scheduler with the given number of workers. If workerCount is zero, one worker per hardware
+//   thread is used.
+TaskScheduler::TaskScheduler(uint workerCount)
+        : currentTask(nullptr), currentGrainSize(1), remainingWork(0), jobNumber(0), nBusyHelpers(0),
+          isStopping(false) {
+    if (workerCount == 0)
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+
+    for (uint i = 0; i < workerCount; i++)
+        queues.emplace_back(new WorkerQueue);
+
+    // Worker 0 is whichever thread calls parallelFor.
+    for (uint i = 1; i < workerCount; i++)
+        threads.emplace_back(&TaskScheduler::helperLoop, this, i);
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        isStopping = true;
+    }
+    jobStarted.notify_all();
+
+    for (auto &thread : threads)
+        thread.join();
+}
+
+// Calls the task on subranges of [begin, end) that together cover the range exactly once, and returns
+//   once all of them have finished. Subranges are no larger than grainSize. The task must be safe to
+//   run on several subranges at the same time. parallelFor must not be called from inside a task.
+void TaskScheduler::parallelFor(uint begin, uint end, uint grainSize, const RangeTask &task) {
+    if (begin >= end)
+        return;
+
+    if (grainSize == 0)
+        grainSize = 1;
+
+    const uint nWorkers = this->workerCount();
+    const uint length = end - begin;
+
+    // If there is nothing to share, run everything on the calling thread.
+    if ((nWorkers == 1) || (length <= grainSize)) {
+        for (uint start = begin; start < end; start += std::min(grainSize, end - start)) {
+            WELT_TRACE_ZONE("task");
+            task(start, start + std::min(grainSize, end - start), 0);
+        }
+        return;
+    }
+
+    currentTask = &task;
+    currentGrainSize = grainSize;
+    remainingWork = length;
+
+    // Give every worker an equal share to start with. Uneven shares get evened out by stealing.
+    for (uint worker = 0; worker < nWorkers; worker++) {
+        const uint shareBegin = begin + (uint) (((unsigned long long) length * worker) / nWorkers);
+        const uint shareEnd = begin + (uint) (((unsigned long long) length * (worker + 1)) / nWorkers);
+        if (shareBegin < shareEnd)
+            this->pushRange(worker, Range{shareBegin, shareEnd});
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        nBusyHelpers = nWorkers - 1;
+        ++jobNumber;
+    }
+    jobStarted.notify_all();
+
+    this->runJob(0);
+
+    // Wait for the helpers to stop looking at the job before it goes out of scope.
+    std::unique_lock<std::mutex> lock(jobMutex);
+    jobFinished.wait(lock, [this] { return nBusyHelpers == 0; });
+    currentTask = nullptr;
+}
+
+// Waits for jobs and helps run them until the scheduler is destroyed.
+void TaskScheduler::helperLoop(uint worker) {
+    uint lastJobNumber = 0;
+#ifdef WELT_TRACE
+    Trace::setThreadName("TaskScheduler worker");
+#endif
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobStarted.wait(lock, [this, lastJobNumber] { return isStopping || (jobNumber != lastJobNumber); });
+            if (isStopping)
+                return;
+            lastJobNumber = jobNumber;
+        }
+
+        this->runJob(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            if (--nBusyHelpers == 0)
+                jobFinished.notify_all();
+        }
+    }
+}
+
+// Runs ranges from the worker's own deque, or stolen from other workers, until the whole job is done.
+void TaskScheduler::runJob(uint worker) {
+    Range range;
+
+    while (remainingWork.load() != 0) {
+        if (!this->popRange(worker, range) && !this->stealRange(worker, range)) {
+            // All remaining work is being run by other workers.
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Split off the upper half until the range is small enough. The halves are left for this
+        //   worker to run next, or for other workers to steal.
+        while ((range.end - range.begin) > currentGrainSize) {
+            const uint middle = range.begin + (range.end - range.begin) / 2;
+            this->pushRange(worker, Range{middle, range.end});
+            range.end = middle;
+        }
+
+        {
+            WELT_TRACE_ZONE("task");
+            (*currentTask)(range.begin, range.end, worker);
+        }
+        remainingWork -= range.end - range.begin;
+    }
+}
+
+// Takes the most recently pushed range from the worker's own deque.
+bool TaskScheduler::popRange(uint worker, Range &range) {
+    WorkerQueue &queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.ranges.empty())
+        return false;
+
+    range = queue.ranges.back();
+    queue.ranges.pop_back();
+    return true;
+}
+
+// Takes the oldest range from another worker's deque, starting with the next worker along.
+bool TaskScheduler::stealRange(uint worker, Range &range) {
+    const uint nWorkers = this->workerCount();
+
+    for (uint i = 1; i < nWorkers; i++) {
+        WorkerQueue &victim = *queues[(worker + i) % nWorkers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.ranges.empty()) {
+            range = victim.ranges.front();
+            victim.ranges.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TaskScheduler::pushRange(uint worker, const Range &range) {
+    WorkerQueue &queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.ranges.push_back(range);
+}
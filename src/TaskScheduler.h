@@ -0,0 +1,75 @@
+#ifndef WELT_TASKSCHEDULER_H
+#define WELT_TASKSCHEDULER_H
+
+#include "universal.h"
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <condition_variable>
+
+// Runs ranges of work on a fixed pool of threads. Each worker owns a deque of ranges. A worker takes
+//   ranges from the back of its own deque, splitting them in half until they are no larger than the
+//   grain size, and pushing the halves it does not run yet back onto its deque. A worker whose deque is
+//   empty steals from the front of another worker's deque, where the largest ranges are. This keeps
+//   every worker busy even when the cost of the work is very uneven across the range.
+// The thread that calls parallelFor takes part as worker 0, so a scheduler with one worker starts no threads.
+class TaskScheduler {
+public:
+    // The task is called with the start and end of a subrange, and the number of the worker running it.
+    typedef std::function<void(uint begin, uint end, uint worker)> RangeTask;
+
+    explicit TaskScheduler(uint workerCount = 0);
+
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler &) = delete;
+
+    TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+    // Returns the number of workers, including the calling thread.
+    uint workerCount() const { return (uint) queues.size(); }
+
+    void parallelFor(uint begin, uint end, uint grainSize, const RangeTask &task);
+
+private:
+    struct Range {
+        uint begin, end;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+
+    // The job currently being run. Only changed while no helper thread is working.
+    const RangeTask *currentTask;
+    uint currentGrainSize;
+    std::atomic<uint> remainingWork; // Number of indices not yet run in the current job.
+
+    std::mutex jobMutex;
+    std::condition_variable jobStarted, jobFinished;
+    uint jobNumber;
+    uint nBusyHelpers;
+    bool isStopping;
+
+    void helperLoop(uint worker);
+
+    void runJob(uint worker);
+
+    bool popRange(uint worker, Range &range);
+
+    bool stealRange(uint worker, Range &range);
+
+    void pushRange(uint worker, const Range &range);
+};
+
+
+#endif //WELT_TASKSCHEDULER_H
@@ -0,0 +1,106 @@
+#include "TickProfiler.h"
+
+#include <algorithm>
+#include <cassert>
+
+// Sets every count and time to zero. The entity type table keeps its memory.
+void TickStats::clear() {
+    tickNumber = 0;
+    tickMs = 0;
+    for (double &ms : phaseMs)
+        ms = 0;
+    entitiesTicked = 0;
+    movesCommitted = 0;
+    movesRejected = 0;
+    entitiesAdded = 0;
+    entitiesDeleted = 0;
+    queries = QueryCounters();
+    for (EntityTypeStats &type : entityTypes)
+        type = EntityTypeStats();
+}
+
+// Adds the counts and times of another TickStats to this one.
+void TickStats::add(const TickStats &other) {
+    tickMs += other.tickMs;
+    for (uint i = 0; i < N_TICK_PHASES; i++)
+        phaseMs[i] += other.phaseMs[i];
+    entitiesTicked += other.entitiesTicked;
+    movesCommitted += other.movesCommitted;
+    movesRejected += other.movesRejected;
+    entitiesAdded += other.entitiesAdded;
+    entitiesDeleted += other.entitiesDeleted;
+    queries.add(other.queries);
+
+    if (other.entityTypes.size() > entityTypes.size())
+        entityTypes.resize(other.entityTypes.size());
+    for (uint i = 0; i < other.entityTypes.size(); i++) {
+        entityTypes[i].nTicked += other.entityTypes[i].nTicked;
+        entityTypes[i].ms += other.entityTypes[i].ms;
+    }
+}
+
+TickProfiler::TickProfiler(uint historyLength) : history(std::max(historyLength, 1u)), nextHistorySlot(0),
+                                                 nTicksInHistory(0), workerEntityTypes(1) {
+}
+
+// Makes a per-worker entity type table for every worker that may tick entities.
+void TickProfiler::setWorkerCount(uint workerCount) {
+    workerEntityTypes.resize(std::max(workerCount, 1u));
+}
+
+// Starts timing a tick and its first phase.
+void TickProfiler::beginTick(uint tickNumber) {
+    currentTick.tickNumber = tickNumber;
+    tickStart = profileNow();
+    phaseStart = tickStart;
+}
+
+// Adds the time since the end of the previous phase, or the start of the tick, to the given phase.
+void TickProfiler::endPhase(TickPhase phase) {
+    const ProfileTime now = profileNow();
+    currentTick.phaseMs[(uint) phase] += profileMs(phaseStart, now);
+    phaseStart = now;
+}
+
+// Merges the per-worker entity type tables into the current tick, and moves it into the history.
+void TickProfiler::endTick() {
+    currentTick.tickMs = profileMs(tickStart, profileNow());
+
+    for (std::vector<EntityTypeStats> &types : workerEntityTypes) {
+        if (types.size() > currentTick.entityTypes.size())
+            currentTick.entityTypes.resize(types.size());
+        for (uint i = 0; i < types.size(); i++) {
+            currentTick.entityTypes[i].nTicked += types[i].nTicked;
+            currentTick.entityTypes[i].ms += types[i].ms;
+            currentTick.entitiesTicked += (uint) types[i].nTicked;
+            types[i] = EntityTypeStats();
+        }
+    }
+
+    totalStats.add(currentTick);
+    totalStats.tickNumber = currentTick.tickNumber;
+
+    // Copying into the slot reuses the memory of the tick it replaces.
+    history[nextHistorySlot] = currentTick;
+    nextHistorySlot = (nextHistorySlot + 1) % history.size();
+    nTicksInHistory = std::min(nTicksInHistory + 1, (uint) history.size());
+
+    currentTick.clear();
+}
+
+// Returns the stats of a tick in the history. 0 is the most recent tick. ticksAgo must be less than historySize.
+const TickStats &TickProfiler::recent(uint ticksAgo) const {
+    assert(ticksAgo < nTicksInHistory);
+
+    return history[(nextHistorySlot + history.size() - 1 - ticksAgo) % history.size()];
+}
+
+// Forgets the history and the totals.
+void TickProfiler::reset() {
+    nextHistorySlot = 0;
+    nTicksInHistory = 0;
+    currentTick.clear();
+    totalStats = TickStats();
+    for (std::vector<EntityTypeStats> &types : workerEntityTypes)
+        types.clear();
+}
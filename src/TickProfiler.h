@@ -0,0 +1,131 @@
+#ifndef WELT_TICKPROFILER_H
+#define WELT_TICKPROFILER_H
+
+#include "universal.h"
+#include <chrono>
+#include <vector>
+
+// Define WELT_PROFILE to have World collect TickStats. Without it, everything inside WELT_PROFILE_ONLY
+//   is compiled out, and World::stats() only ever holds empty ticks.
+#ifdef WELT_PROFILE
+#define WELT_PROFILE_ONLY(...) __VA_ARGS__
+#else
+#define WELT_PROFILE_ONLY(...)
+#endif
+
+typedef std::chrono::steady_clock::time_point ProfileTime;
+
+inline ProfileTime profileNow() { return std::chrono::steady_clock::now(); }
+
+// Returns the number of milliseconds from start to end.
+inline double profileMs(const ProfileTime &start, const ProfileTime &end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// The parts of World::tick that are timed separately.
+enum class TickPhase {
+    COLLECT,  // Waking entities and finding the ones that are due.
+    ENTITIES, // Calling the tick function of every due entity.
+    COMMIT    // Applying the recorded intents.
+};
+
+const uint N_TICK_PHASES = 3;
+
+// What the spatial queries did. A candidate is an object in a scanned chunk that was checked against
+//   the query, and it is accepted if it was inside the query's area.
+struct QueryCounters {
+    unsigned long long queries, chunksScanned, candidatesTested, candidatesAccepted;
+
+    QueryCounters() : queries(0), chunksScanned(0), candidatesTested(0), candidatesAccepted(0) {}
+
+    void add(const QueryCounters &other) {
+        queries += other.queries;
+        chunksScanned += other.chunksScanned;
+        candidatesTested += other.candidatesTested;
+        candidatesAccepted += other.candidatesAccepted;
+    }
+};
+
+// Adds amount to a field of the QueryCounters pointed to by counters, if profiling is compiled in and
+//   counters is not nullptr.
+#ifdef WELT_PROFILE
+#define WELT_COUNT_QUERY(counters, field, amount) do { if (counters) (counters)->field += (amount); } while (false)
+#else
+#define WELT_COUNT_QUERY(counters, field, amount) do {} while (false)
+#endif
+
+// The time spent ticking the entities of one object type.
+struct EntityTypeStats {
+    unsigned long long nTicked;
+    double ms;
+
+    EntityTypeStats() : nTicked(0), ms(0) {}
+};
+
+// What happened during one tick. Changes made between ticks, such as entities added by the game, are
+//   counted in the next tick.
+struct TickStats {
+    uint tickNumber;
+    double tickMs;
+    double phaseMs[N_TICK_PHASES];
+    uint entitiesTicked;
+    uint movesCommitted; // Entities moved, by intents or by calls to moveEntity and tryMove.
+    uint movesRejected;  // Move intents that could not be applied at the end of the tick.
+    uint entitiesAdded, entitiesDeleted;
+    QueryCounters queries;
+    std::vector<EntityTypeStats> entityTypes; // Indexed by the entities' getObjectType.
+
+    TickStats() { this->clear(); }
+
+    void clear();
+
+    void add(const TickStats &other);
+};
+
+// Collects TickStats for World, and keeps the stats of the most recent ticks in a ring buffer.
+// Entities ticked on different workers are timed into separate per-worker tables, which are merged
+//   when the tick ends, so workers never write to the same memory.
+class TickProfiler {
+public:
+    explicit TickProfiler(uint historyLength = 256);
+
+    void setWorkerCount(uint workerCount);
+
+    void beginTick(uint tickNumber);
+
+    void endPhase(TickPhase phase);
+
+    // Adds the time since start to the entity type's total on the given worker.
+    void recordEntity(uint worker, uint objectType, const ProfileTime &start) {
+        std::vector<EntityTypeStats> &types = workerEntityTypes[worker];
+        if (objectType >= types.size())
+            types.resize(objectType + 1);
+        types[objectType].nTicked++;
+        types[objectType].ms += profileMs(start, profileNow());
+    }
+
+    void endTick();
+
+    // Returns the stats being collected for the tick in progress, or for the next tick between ticks.
+    TickStats &current() { return currentTick; }
+
+    // Returns the number of ticks in the history, up to the history length.
+    uint historySize() const { return nTicksInHistory; }
+
+    const TickStats &recent(uint ticksAgo = 0) const;
+
+    // Returns the sum of every tick since the profiler was created or reset.
+    const TickStats &totals() const { return totalStats; }
+
+    void reset();
+
+private:
+    std::vector<TickStats> history;
+    uint nextHistorySlot, nTicksInHistory;
+    TickStats currentTick, totalStats;
+    std::vector<std::vector<EntityTypeStats>> workerEntityTypes;
+    ProfileTime tickStart, phaseStart;
+};
+
+
+#endif //WELT_TICKPROFILER_H
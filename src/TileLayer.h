@@ -0,0 +1,86 @@
+#ifndef WELT_TILELAYER_H
+#define WELT_TILELAYER_H
+
+#include "TileMap.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+// One value per tile of a map, stored in pages of the same size and layout as the pages of a TileMap.
+//   A paged TileLayer only allocates a page the first time a value other than the empty value is written
+//   to it, and reads from unallocated pages return the empty value, so a layer of a large paged map only
+//   uses memory for the area where something has been placed. Otherwise, every page is allocated by reset.
+template<class Value>
+class TileLayer {
+public:
+    // Sizes the layer for a map of the given dimensions, with every tile holding emptyValue.
+    //   If enough memory cannot be allocated, throw bad_alloc.
+    void reset(uint width, uint height, Value emptyValue, bool isPaged) {
+        this->emptyValue = emptyValue;
+        nPagesPerRow = (width + TILE_PAGE_MASK) >> TILE_PAGE_BITS;
+        nAllocatedPages = 0;
+        pages.clear();
+        pages.resize(nPagesPerRow * ((height + TILE_PAGE_MASK) >> TILE_PAGE_BITS));
+        if (!isPaged)
+            allocateAll();
+    }
+
+    // Allocates every page that has not been allocated yet.
+    void allocateAll() {
+        for (uint i = 0; i < pages.size(); i++) {
+            if (!pages[i])
+                allocatePage(i);
+        }
+    }
+
+    // Returns the value of the tile at the given coordinate, without allocating.
+    //   The coordinate must be inside the map.
+    Value get(const Coordinate &cord) const {
+        const Value *page = pages[pageNumberOf(cord)].get();
+        return page ? page[indexInPage(cord)] : emptyValue;
+    }
+
+    // Returns the value of the tile at the given coordinate for writing, allocating its page if needed.
+    Value &at(const Coordinate &cord) {
+        Value *page = pages[pageNumberOf(cord)].get();
+        if (!page)
+            page = allocatePage(pageNumberOf(cord));
+        return page[indexInPage(cord)];
+    }
+
+    // Sets the value of the tile at the given coordinate. Writing the empty value to an unallocated
+    //   page does nothing, since that is what the page already reads as.
+    void set(const Coordinate &cord, Value value) {
+        Value *page = pages[pageNumberOf(cord)].get();
+        if (page)
+            page[indexInPage(cord)] = value;
+        else if (!(value == emptyValue))
+            allocatePage(pageNumberOf(cord))[indexInPage(cord)] = value;
+    }
+
+    // Returns the number of pages that have been allocated.
+    uint allocatedPageCount() const { return nAllocatedPages; }
+
+private:
+    std::vector<std::unique_ptr<Value[]>> pages; // nullptr for pages that have not been allocated.
+    Value emptyValue{};
+    uint nPagesPerRow = 0, nAllocatedPages = 0;
+
+    uint pageNumberOf(const Coordinate &cord) const {
+        return ((cord.y >> TILE_PAGE_BITS) * nPagesPerRow) + (cord.x >> TILE_PAGE_BITS);
+    }
+
+    static uint indexInPage(const Coordinate &cord) {
+        return DefaultGridLayout::indexInSquare(cord.x & TILE_PAGE_MASK, cord.y & TILE_PAGE_MASK, TILE_PAGE_BITS);
+    }
+
+    Value *allocatePage(uint pageNumber) {
+        pages[pageNumber].reset(new Value[TILES_PER_PAGE]);
+        std::fill(pages[pageNumber].get(), pages[pageNumber].get() + TILES_PER_PAGE, emptyValue);
+        nAllocatedPages++;
+        return pages[pageNumber].get();
+    }
+};
+
+
+#endif //WELT_TILELAYER_H
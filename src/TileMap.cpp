@@ -1,54 +1,174 @@
 #include "TileMap.h"
+#include "DeltaJournal.h"
+#include "TraceWriter.h"
 
-TileMap::TileMap(uint height, uint width) {
+// Returns the element that appears most often in the given elements. Ties go to the one seen first.
+//   At most (1 << (2 * OVERVIEW_BASE_BITS)) elements may be given.
+static DisplayArrayElement dominantElement(const DisplayArrayElement *elements, uint nElements) {
+    // Regions rarely hold more than a few different looks, so the looks seen are counted in a short list.
+    DisplayArrayElement looks[1u << (2 * OVERVIEW_BASE_BITS)];
+    uint counts[1u << (2 * OVERVIEW_BASE_BITS)];
+    uint nLooks = 0, best = 0;
+
+    for (uint i = 0; i < nElements; i++) {
+        uint look = 0;
+        while ((look < nLooks) && !(looks[look] == elements[i]))
+            look++;
+
+        if (look == nLooks) {
+            looks[nLooks] = elements[i];
+            counts[nLooks++] = 0;
+        }
+
+        if (++counts[look] > counts[best])
+            best = look;
+    }
+
+    return looks[best];
+}
+
+template<class Layout>
+BasicTileMap<Layout>::BasicTileMap(uint height, uint width, bool isPaged) {
 // Make sure the World has valid dimensions. If something is wrong, throw invalid_argument.
     if ((height == 0) || (width == 0))
         throw std::invalid_argument("Cannot create a TileMap with any dimension that is zero");
 
-    // Create the tiles in the TileMap. If enough memory cannot be allocated, throw bad_alloc.
-    try {
-        tiles = new Tile[width * height];
-    } catch (std::bad_alloc &bad) {
-        throw bad;
-    }
-
     // Save the map's size.
     this->_height = height;
     this->_width = width;
+    nPagesPerRow = (width + TILE_PAGE_MASK) >> TILE_PAGE_BITS;
+    nAllocatedPages = 0;
+    _allTilesChanged = true;
+    _isPaged = isPaged;
+    journal = nullptr;
 
     // Calculate and save the maximum possible coordinate of the TileMap.
     _maxCord = Coordinate{width - 1, height - 1};
 
+    // Create the page table. Unless the map is paged, create every page now.
+    //   If enough memory cannot be allocated, throw bad_alloc.
+    pages.assign(nPagesPerRow * ((height + TILE_PAGE_MASK) >> TILE_PAGE_BITS), nullptr);
+    isPageBorrowed.assign(pages.size(), false);
+    if (!isPaged) {
+        try {
+            for (uint i = 0; i < pages.size(); i++)
+                this->allocatePage(i);
+        } catch (std::bad_alloc &bad) {
+            for (Tile *page : pages)
+                delete[] page;
+            throw bad;
+        }
+    }
+
     assert(this->_width != 0);
     assert(this->_height != 0);
-    assert(tiles);
 }
 
-TileMap::~TileMap() {
-    delete[] tiles;
+template<class Layout>
+BasicTileMap<Layout>::~BasicTileMap() {
+    for (uint i = 0; i < pages.size(); i++) {
+        if (!isPageBorrowed[i])
+            delete[] pages[i];
+    }
 }
 
 // Returns the height of the TileMap.
-uint TileMap::height() noexcept {
+template<class Layout>
+uint BasicTileMap<Layout>::height() const noexcept {
     return _height;
 }
 
 // Returns the width of the TileMap.
-uint TileMap::width() noexcept {
+template<class Layout>
+uint BasicTileMap<Layout>::width() const noexcept {
     return _width;
 }
 
-// Returns a pointer to the tile at the given coordinate. If the given
-//   coordinate is outside the bounds of the TileMap, the function returns nullptr.
-Tile *TileMap::at(const Coordinate &coordinate) {
+// Returns a pointer to the tile at the given coordinate for writing, allocating the tile's page if needed.
+//   If the given coordinate is outside the bounds of the TileMap, or the page cannot be allocated,
+//   the function returns nullptr. Use tileAt to read a tile without allocating.
+template<class Layout>
+Tile *BasicTileMap<Layout>::at(const Coordinate &coordinate) {
     if (cordOutsideBound(this->_maxCord, coordinate))
         return nullptr;
-    else
-        return &tiles[getArrayIndex(coordinate, _width)];
+
+    try {
+        return &this->allocatePage(pageNumberOf(coordinate))[indexInPage(coordinate)];
+    } catch (std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+// Sets the tile that unallocated pages read as, and that new pages are filled with. Tiles in pages
+//   that have already been allocated are not changed. Returns true if successful. Returns false if the
+//   registry is full, a material's display ID does not fit in a Tile, or the wall material's base health
+//   does not fit in a Tile.
+template<class Layout>
+bool BasicTileMap<Layout>::setDefaultTile(const Material &floorMaterial, const Material &wallMaterial) noexcept {
+    if ((floorMaterial.defaultDisplayFloor > UINT8_MAX) || (wallMaterial.defaultDisplayFloor > UINT8_MAX) ||
+        (wallMaterial.baseHealth > UINT16_MAX))
+        return false;
+
+    Tile tile;
+    try {
+        tile.floorMaterial = materials.intern(floorMaterial);
+        tile.wallMaterial = materials.intern(wallMaterial);
+    } catch (std::length_error &) {
+        return false;
+    }
+    tile.floorDisplay = (uint8_t) floorMaterial.defaultDisplayFloor;
+    tile.wallDisplay = (uint8_t) wallMaterial.defaultDisplayFloor;
+    tile.wallHealth = (uint16_t) wallMaterial.baseHealth;
+
+    defaultTile = tile;
+    _allTilesChanged = true;
+    if (!overview.isEmpty())
+        overview.markAllChanged();
+    if (journal)
+        journal->recordDefaultTile(tile.floorMaterial, tile.wallMaterial, materials);
+    return true;
+}
+
+// Returns the page with the given number, allocating it and filling it with the default tile if needed.
+template<class Layout>
+Tile *BasicTileMap<Layout>::allocatePage(const uint pageNumber) {
+    Tile *&page = pages[pageNumber];
+    if (!page) {
+        page = new Tile[TILES_PER_PAGE];
+        std::fill(page, page + TILES_PER_PAGE, defaultTile);
+        ++nAllocatedPages;
+    }
+
+    return page;
+}
+
+// Uses the given tiles, which the TileMap does not own, as a page that has not been allocated yet. The tiles
+//   must stay valid and writable until the TileMap is destroyed.
+template<class Layout>
+void BasicTileMap<Layout>::borrowPage(const uint pageNumber, Tile *tiles) {
+    assert(!pages[pageNumber]);
+
+    pages[pageNumber] = tiles;
+    isPageBorrowed[pageNumber] = true;
+    ++nAllocatedPages;
+}
+
+// Returns the wall material of the tile at the given coordinate. The coordinate must be inside the TileMap.
+template<class Layout>
+const Material &BasicTileMap<Layout>::wallMaterialAt(const Coordinate &coordinate) const {
+    assert(!cordOutsideBound(this->_maxCord, coordinate));
+
+    return materials.get(this->tileAt(coordinate).wallMaterial);
 }
 
 // Sets the floor material of the specified tile to the given material. Returns true if successful.
-bool TileMap::setFloorMaterial(const Coordinate &coordinate, const Material &desiredMaterial) noexcept {
+//   Returns false if the tile is outside the map, the registry is full, or the material's display ID
+//   does not fit in a Tile.
+template<class Layout>
+bool BasicTileMap<Layout>::setFloorMaterial(const Coordinate &coordinate, const Material &desiredMaterial) noexcept {
+    if (desiredMaterial.defaultDisplayFloor > UINT8_MAX)
+        return false;
+
     // Get the tile at the given coordinate.
     Tile *tile = this->at(coordinate);
 
@@ -57,15 +177,28 @@ bool TileMap::setFloorMaterial(const Coordinate &coordinate, const Material &des
         return false;
 
     // Set the tile's floor material and displayID.
-    tile->floorMaterial = desiredMaterial;
-    tile->floorDisplay = desiredMaterial.defaultDisplayFloor;
+    try {
+        tile->floorMaterial = materials.intern(desiredMaterial);
+    } catch (std::length_error &) {
+        return false;
+    }
+    tile->floorDisplay = (uint8_t) desiredMaterial.defaultDisplayFloor;
+    this->markTileChanged(coordinate);
+    if (journal)
+        journal->recordFloor(coordinate, tile->floorMaterial, materials);
 
     return true;
 }
 
 // Sets the wall material of the specified tile to the given material. Returns true if successful.
-bool
-TileMap::setWallMaterial(const Coordinate &coordinate, const Material &desiredMaterial, uint startingHealth) noexcept {
+//   Returns false if the tile is outside the map, the registry is full, or the material's display ID or
+//   base health does not fit in a Tile.
+template<class Layout>
+bool BasicTileMap<Layout>::setWallMaterial(const Coordinate &coordinate, const Material &desiredMaterial,
+                                           uint startingHealth) noexcept {
+    if ((desiredMaterial.defaultDisplayFloor > UINT8_MAX) || (desiredMaterial.baseHealth > UINT16_MAX))
+        return false;
+
     // Get the tile at the given coordinate.
     Tile *tile = this->at(coordinate);
 
@@ -74,15 +207,23 @@ TileMap::setWallMaterial(const Coordinate &coordinate, const Material &desiredMa
         return false;
 
     // Set the tile's wall material, displayID, and health.
-    tile->wallMaterial = desiredMaterial;
-    tile->wallDisplay = desiredMaterial.defaultDisplayFloor;
-    tile->wallHealth = desiredMaterial.baseHealth;
+    try {
+        tile->wallMaterial = materials.intern(desiredMaterial);
+    } catch (std::length_error &) {
+        return false;
+    }
+    tile->wallDisplay = (uint8_t) desiredMaterial.defaultDisplayFloor;
+    tile->wallHealth = (uint16_t) desiredMaterial.baseHealth;
+    this->markTileChanged(coordinate);
+    if (journal)
+        journal->recordWall(coordinate, tile->wallMaterial, startingHealth, materials);
 
     return true;
 }
 
 // Returns a DisplayArray representing everything in the TileMap.
-DisplayArray TileMap::generateDisplayArray() {
+template<class Layout>
+DisplayArray BasicTileMap<Layout>::generateDisplayArray() {
     // Create a DisplayArray and initialize its dimensions.
     DisplayArray result;
     result.width = _width;
@@ -104,7 +245,9 @@ DisplayArray TileMap::generateDisplayArray() {
 }
 
 // Take an already existing DisplayArray and loads it with everything needed to represent the TileMap.
-void TileMap::loadDisplayArray(DisplayArray &displayArray) {
+template<class Layout>
+void BasicTileMap<Layout>::loadDisplayArray(DisplayArray &displayArray) {
+    WELT_TRACE_ZONE("TileMap::loadDisplayArray");
     // If the display array is the wrong dimensions or does not exist, delete it and create a new one.
     if ((displayArray.height != _height) || (displayArray.width != _width) || !displayArray.displayData) {
         delete[] displayArray.displayData;
@@ -112,37 +255,162 @@ void TileMap::loadDisplayArray(DisplayArray &displayArray) {
         return;
     }
 
-    // Load the DisplayArrayElement array with the display info for every tile in the chunk.
+    this->loadDisplayArrayRows(displayArray, 0, _height);
+}
+
+// Loads the rows [firstRow, endRow) of a DisplayArray that already has the dimensions of the TileMap.
+//   Separate row ranges can be loaded at the same time.
+template<class Layout>
+void BasicTileMap<Layout>::loadDisplayArrayRows(DisplayArray &displayArray, uint firstRow, uint endRow) {
+    this->loadDisplayArrayRows(displayArray, ViewRect{0, 0, _width, _height}, firstRow, endRow);
+}
+
+// Loads only the tiles inside the view into a DisplayArray the size of the view. The view is clipped to
+//   the TileMap first. Element (0, 0) of the DisplayArray is the tile at the view's top left corner.
+template<class Layout>
+void BasicTileMap<Layout>::loadDisplayArray(DisplayArray &displayArray, const ViewRect &view) {
+    WELT_TRACE_ZONE("TileMap::loadDisplayArray");
+    const ViewRect clippedView = clipViewRect(view, _width, _height);
+    resizeDisplayArray(displayArray, clippedView.width, clippedView.height);
+    this->loadDisplayArrayRows(displayArray, clippedView, 0, clippedView.height);
+}
+
+// Loads the rows [firstRow, endRow) of the view into a DisplayArray that already has the dimensions of
+//   the view. Rows are counted from the top of the view, which must be inside the TileMap.
+template<class Layout>
+void BasicTileMap<Layout>::loadDisplayArrayRows(DisplayArray &displayArray, const ViewRect &view, uint firstRow,
+                                                uint endRow) {
     Coordinate pos = Coordinate{0, 0};
-    for (pos.y = 0; pos.y < displayArray.width; pos.y++) {
-        for (pos.x = 0; pos.x < displayArray.height; pos.x++) {
-            displayArray.displayData[getArrayIndex(pos, displayArray.width)] = this->getTileDisplayElement(pos);
+    for (uint row = firstRow; (row < endRow) && (row < view.height); row++) {
+        pos.y = view.y + row;
+        DisplayArrayElement *rowData = displayArray.displayData + ((size_t) row * displayArray.width);
+        for (uint column = 0; column < view.width; column++) {
+            pos.x = view.x + column;
+            rowData[column] = this->getTileDisplayElement(pos);
         }
     }
 }
 
 // Returns true if there is no tile to represent the given coordinate.
-bool TileMap::isInvalidTile(const Coordinate &coordinate) noexcept {
+template<class Layout>
+bool BasicTileMap<Layout>::isInvalidTile(const Coordinate &coordinate) noexcept {
     return cordOutsideBound(this->_maxCord, coordinate);
 }
 
 // Returns a display element loaded with the information for the given coordinate.
-DisplayArrayElement TileMap::getTileDisplayElement(Coordinate coordinate) noexcept {
+template<class Layout>
+DisplayArrayElement BasicTileMap<Layout>::getTileDisplayElement(Coordinate coordinate) noexcept {
     DisplayArrayElement result = DisplayArrayElement{DCID_VOID, DCID_VOID, COLOR_VOID, COLOR_VOID};
 
     // If the tile is not valid (nullptr,) return.
     if (isInvalidTile(coordinate))
         return result;
 
-    result.BackgroundInfo = this->at(coordinate)->floorDisplay;
-    result.ForegroundInfo = this->at(coordinate)->wallDisplay;
-    result.ForegroundColor = this->at(coordinate)->wallMaterial.color;
-    result.BackgroundColor = this->at(coordinate)->floorMaterial.color;
+    const Tile &tile = this->tileAt(coordinate);
+    result.BackgroundInfo = tile.floorDisplay;
+    result.ForegroundInfo = tile.wallDisplay;
+    result.ForegroundColor = materials.get(tile.wallMaterial).color;
+    result.BackgroundColor = materials.get(tile.floorMaterial).color;
 
     return result;
 }
 
+// Loads a level of the overview into a DisplayArray the size of that level. Each element is the look
+//   that is most common in the area it covers. The overview is built by the first call, and after that
+//   only the areas that changed are summarised again, so the cost depends on the size of the level and the
+//   number of changes rather than the size of the map. If the level does not exist, the top level is loaded.
+template<class Layout>
+void BasicTileMap<Layout>::loadOverview(DisplayArray &displayArray, uint level) {
+    WELT_TRACE_ZONE("TileMap::loadOverview");
+    this->refreshOverview();
+    level = std::min(level, overview.levelCount() - 1);
+
+    resizeDisplayArray(displayArray, overview.levelWidth(level), overview.levelHeight(level));
+    const DisplayArrayElement *levelData = overview.levelData(level);
+    std::copy(levelData, levelData + ((size_t) displayArray.width * displayArray.height), displayArray.displayData);
+}
+
+// Returns the number of levels the overview has, building the overview if needed.
+template<class Layout>
+uint BasicTileMap<Layout>::overviewLevelCount() {
+    this->refreshOverview();
+    return overview.levelCount();
+}
+
+// Frees the memory used by the overview. It is built again by the next loadOverview.
+template<class Layout>
+void BasicTileMap<Layout>::discardOverview() {
+    overview.clear();
+}
+
+// Builds the overview if it does not exist, and summarises again the tiles that changed since last time.
+template<class Layout>
+void BasicTileMap<Layout>::refreshOverview() {
+    if (overview.isEmpty()) {
+        overview.resize(_width, _height, DisplayArrayElement());
+        overview.markAllChanged();
+    }
+
+    const uint cellSide = 1u << OVERVIEW_BASE_BITS;
+    const uint baseWidth = overview.levelWidth(0);
+    DisplayArrayElement elements[1u << (2 * OVERVIEW_BASE_BITS)];
+
+    for (uint cellIndex : overview.changedBaseCells()) {
+        const uint cellX = cellIndex % baseWidth, cellY = cellIndex / baseWidth;
+        const Coordinate origin = Coordinate{cellX << OVERVIEW_BASE_BITS, cellY << OVERVIEW_BASE_BITS};
+
+        // A cell of an unallocated page only holds the default tile.
+        if (!pages[pageNumberOf(origin)]) {
+            overview.baseCell(cellX, cellY) = this->getTileDisplayElement(origin);
+            continue;
+        }
+
+        uint nElements = 0;
+        Coordinate pos = Coordinate{0, 0};
+        for (pos.y = origin.y; (pos.y < origin.y + cellSide) && (pos.y < _height); pos.y++) {
+            for (pos.x = origin.x; (pos.x < origin.x + cellSide) && (pos.x < _width); pos.x++)
+                elements[nElements++] = this->getTileDisplayElement(pos);
+        }
+        overview.baseCell(cellX, cellY) = dominantElement(elements, nElements);
+    }
+
+    overview.refresh([](const DisplayArrayElement *children, uint nChildren) {
+        return dominantElement(children, nChildren);
+    });
+}
+
+// Records that a tile's display has changed. Once more than an eighth of the map has changed,
+//   the whole map is marked as changed instead, which is cheaper to reload than a long list.
+template<class Layout>
+void BasicTileMap<Layout>::markTileChanged(const Coordinate &coordinate) {
+    if (!overview.isEmpty())
+        overview.markBaseChanged(coordinate.x >> OVERVIEW_BASE_BITS, coordinate.y >> OVERVIEW_BASE_BITS);
+
+    if (_allTilesChanged)
+        return;
+
+    if (_changedTiles.size() >= (((size_t) _width * _height) / 8) + 64) {
+        _allTilesChanged = true;
+        _changedTiles.clear();
+        return;
+    }
+
+    _changedTiles.push_back(getArrayIndex(coordinate, _width));
+}
+
+// Forgets which tiles have changed. Called once the changes have been displayed.
+template<class Layout>
+void BasicTileMap<Layout>::clearChangedTiles() {
+    _changedTiles.clear();
+    _allTilesChanged = false;
+}
+
 // Returns the max coordinate for the TileMap.
-const Coordinate &TileMap::maxCord() const {
+template<class Layout>
+const Coordinate &BasicTileMap<Layout>::maxCord() const {
     return _maxCord;
 }
+
+template class BasicTileMap<RowMajorLayout>;
+
+template class BasicTileMap<MortonLayout>;
@@ -4,21 +4,69 @@
 #include "DisplayIDdef.h"
 #include "universal.h"
 #include "tile.h"
+#include "GridLayout.h"
+#include "DisplayPyramid.h"
 #include "cassert"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+// Tiles are stored in square pages of (1 << TILE_PAGE_BITS) tiles per side.
+const uint TILE_PAGE_BITS = 6;
+const uint TILE_PAGE_MASK = (1u << TILE_PAGE_BITS) - 1;
+const uint TILES_PER_PAGE = 1u << (2 * TILE_PAGE_BITS);
+
+// Every overview cell of level 0 must be inside a single page.
+static_assert(OVERVIEW_BASE_BITS <= TILE_PAGE_BITS, "Overview cells must not span pages");
+
+class DeltaJournal;
+
+// A grid of tiles, stored in fixed size pages. A paged TileMap only allocates a page the first time one
+//   of its tiles is written, and reads from unallocated pages return the map's default tile, so a large map
+//   starts instantly and only uses memory for the area that has been edited. Otherwise, every page is
+//   allocated when the TileMap is created.
+// The Layout policy (see GridLayout.h) sets the order of the tiles inside each page. Pages themselves
+//   are kept in row-major order.
+// Pages can also be borrowed from memory the TileMap does not own, such as a snapshot file mapped by
+//   WorldSnapshot, which stays alive until the TileMap is destroyed.
+template<class Layout>
+class BasicTileMap {
+    friend class WorldSnapshot;
+    friend class DeltaJournal;
+    friend class JournalReplay;
 
-class TileMap {
 public:
-    TileMap(uint height, uint width);
+    BasicTileMap(uint height, uint width, bool isPaged = false);
 
-    virtual ~TileMap();
+    virtual ~BasicTileMap();
 
     // Returns the height of the TileMap.
-    uint height() noexcept;
+    uint height() const noexcept;
 
-    uint width() noexcept;
+    uint width() const noexcept;
 
     Tile *at(const Coordinate &coordinate);
 
+    // Returns the tile at the given coordinate for reading, without allocating.
+    //   The coordinate must be inside the TileMap.
+    const Tile &tileAt(const Coordinate &coordinate) const {
+        const Tile *page = pages[pageNumberOf(coordinate)];
+        return page ? page[indexInPage(coordinate)] : defaultTile;
+    }
+
+    bool setDefaultTile(const Material &floorMaterial, const Material &wallMaterial) noexcept;
+
+    // Returns the number of pages that have been allocated.
+    uint allocatedPageCount() const { return nAllocatedPages; }
+
+    // Returns true if pages are only allocated when first written.
+    bool isPaged() const { return _isPaged; }
+
+    // Returns the Material with the given ID, as stored in a Tile.
+    const Material &material(MaterialID id) const { return materials.get(id); }
+
+    const Material &wallMaterialAt(const Coordinate &coordinate) const;
+
     bool setFloorMaterial(const Coordinate &coordinate, const Material &desiredMaterial) noexcept;
 
     bool setWallMaterial(const Coordinate &cord, const Material &desiredMaterial, uint startingHealth) noexcept;
@@ -27,17 +75,65 @@ public:
 
     void loadDisplayArray(DisplayArray &displayArray);
 
+    void loadDisplayArrayRows(DisplayArray &displayArray, uint firstRow, uint endRow);
+
+    void loadDisplayArray(DisplayArray &displayArray, const ViewRect &view);
+
+    void loadDisplayArrayRows(DisplayArray &displayArray, const ViewRect &view, uint firstRow, uint endRow);
+
+    DisplayArrayElement getTileDisplayElement(Coordinate coordinate) noexcept;
+
+    void loadOverview(DisplayArray &displayArray, uint level);
+
+    // Returns the number of levels the overview has. See DisplayPyramid.h for what each level covers.
+    uint overviewLevelCount();
+
+    void discardOverview();
+
+    // Returns the row-major indices of the tiles changed since clearChangedTiles was last called.
+    //   A tile may be listed more than once. Not valid if allTilesChanged returns true.
+    const std::vector<uint> &changedTiles() const { return _changedTiles; }
+
+    // Returns true if too many tiles have changed to list them, or the default tile changed.
+    bool allTilesChanged() const { return _allTilesChanged; }
+
+    void clearChangedTiles();
+
     const Coordinate &maxCord() const;
 
 private:
-    Tile *tiles;
+    std::vector<Tile *> pages; // nullptr for pages that have not been allocated.
+    std::vector<bool> isPageBorrowed;
+    std::shared_ptr<void> borrowedStorage; // Holds the memory of borrowed pages.
+    Tile defaultTile;
+    MaterialRegistry materials;
     Coordinate _maxCord;
-    uint _width, _height;
+    uint _width, _height, nPagesPerRow, nAllocatedPages;
+    std::vector<uint> _changedTiles;
+    bool _allTilesChanged, _isPaged;
+    DisplayPyramid<DisplayArrayElement> overview; // Empty until the first loadOverview.
+    DeltaJournal *journal; // Records every tile change while a DeltaJournal is recording, or nullptr.
+
+    uint pageNumberOf(const Coordinate &coordinate) const {
+        return ((coordinate.y >> TILE_PAGE_BITS) * nPagesPerRow) + (coordinate.x >> TILE_PAGE_BITS);
+    }
+
+    static uint indexInPage(const Coordinate &coordinate) {
+        return Layout::indexInSquare(coordinate.x & TILE_PAGE_MASK, coordinate.y & TILE_PAGE_MASK, TILE_PAGE_BITS);
+    }
+
+    Tile *allocatePage(uint pageNumber);
+
+    void borrowPage(uint pageNumber, Tile *tiles);
 
     bool isInvalidTile(const Coordinate &coordinate) noexcept;
 
-    DisplayArrayElement getTileDisplayElement(Coordinate coordinate) noexcept;
+    void markTileChanged(const Coordinate &coordinate);
+
+    void refreshOverview();
 };
 
+typedef BasicTileMap<DefaultGridLayout> TileMap;
+
 
 #endif //WELT_TILEMAP_H
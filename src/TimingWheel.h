@@ -0,0 +1,54 @@
+#ifndef WELT_TIMINGWHEEL_H
+#define WELT_TIMINGWHEEL_H
+
+#include "universal.h"
+#include <vector>
+
+// A tick that never comes. Used as the wake tick of objects that only wake up when something happens.
+const uint TICK_NEVER = 0xFFFFFFFF;
+
+// Buckets IDs by the tick they are due on. The wheel has a fixed number of buckets, and a tick's bucket
+//   is its number modulo that size, so scheduling is O(1) and only the bucket for the current tick is
+//   looked at when collecting. IDs due further ahead than one turn of the wheel stay in their bucket until
+//   their tick comes round.
+// The wheel does not store wake ticks itself. The owner keeps the real wake tick of every object, so an ID
+//   can be rescheduled by scheduling it again. Entries whose wake tick no longer matches are dropped.
+template<class ID_Type>
+class TimingWheel {
+public:
+    explicit TimingWheel(uint bucketBits = 8) : buckets(1u << bucketBits), bucketMask((1u << bucketBits) - 1) {}
+
+    // Adds the ID to the bucket for the given tick.
+    void schedule(ID_Type id, uint tick) { buckets[tick & bucketMask].push_back(id); }
+
+    template<class WakeTickOf, class OnDue>
+    void collect(uint tick, WakeTickOf &&wakeTickOf, OnDue &&onDue);
+
+private:
+    std::vector<std::vector<ID_Type>> buckets;
+    uint bucketMask;
+};
+
+// Calls onDue(id) for every ID in the given tick's bucket whose wake tick, as returned by wakeTickOf(id),
+//   is that tick. IDs due on a later turn of the wheel are kept. All others are stale and are dropped.
+template<class ID_Type>
+template<class WakeTickOf, class OnDue>
+void TimingWheel<ID_Type>::collect(uint tick, WakeTickOf &&wakeTickOf, OnDue &&onDue) {
+    std::vector<ID_Type> &bucket = buckets[tick & bucketMask];
+
+    uint nKept = 0;
+    for (uint i = 0; i < bucket.size(); i++) {
+        const ID_Type id = bucket[i];
+        const uint wakeTick = wakeTickOf(id);
+
+        if (wakeTick == tick)
+            onDue(id);
+        else if ((wakeTick != TICK_NEVER) && (wakeTick > tick) && ((wakeTick & bucketMask) == (tick & bucketMask)))
+            bucket[nKept++] = id;
+    }
+
+    bucket.resize(nKept);
+}
+
+
+#endif //WELT_TIMINGWHEEL_H
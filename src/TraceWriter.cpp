@@ -0,0 +1,181 @@
+#include "TraceWriter.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Each thread can hold (1 << TRACE_BUFFER_BITS) events that have not been written yet.
+const uint TRACE_BUFFER_BITS = 16;
+
+// How long the writer thread waits between draining the buffers.
+const std::chrono::milliseconds TRACE_FLUSH_INTERVAL(10);
+
+std::atomic<bool> Trace::isTraceRunning(false);
+
+TraceThreadBuffer::TraceThreadBuffer(uint threadNumber, const char *threadName)
+        : threadNumber(threadNumber), threadName(threadName), isNameWritten(false), nDropped(0),
+          events(1u << TRACE_BUFFER_BITS), eventMask((1u << TRACE_BUFFER_BITS) - 1), nextWrite(0), nextRead(0) {
+}
+
+namespace {
+    // Everything the trace shares between threads. It is never destroyed, and neither are the buffers, so a
+    //   thread never has to check whether its buffer still exists, even while the program exits.
+    struct TraceState {
+        std::mutex mutex; // Guards the list of buffers, the thread names, and the file.
+        std::vector<std::unique_ptr<TraceThreadBuffer>> buffers;
+        std::chrono::steady_clock::time_point startTime;
+        FILE *file = nullptr;
+        bool isFirstEvent = true;
+
+        std::thread writer;
+        std::mutex stopMutex;
+        std::condition_variable stopRequested;
+        bool isStopping = false;
+
+        void writeEvent(const TraceThreadBuffer &buffer, const TraceEvent &event);
+
+        void writePending();
+
+        void writerLoop();
+    };
+
+    TraceState &traceState() {
+        static TraceState *state = new TraceState;
+        return *state;
+    }
+
+    thread_local TraceThreadBuffer *threadBuffer = nullptr;
+    thread_local const char *threadName = nullptr;
+
+    void TraceState::writeEvent(const TraceThreadBuffer &buffer, const TraceEvent &event) {
+        fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                isFirstEvent ? "" : ",\n", event.name, buffer.threadNumber, event.startNs / 1000.0,
+                (event.endNs - event.startNs) / 1000.0);
+        isFirstEvent = false;
+    }
+
+    // Writes the name of every new thread, and every event recorded since the last call.
+    void TraceState::writePending() {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (auto &buffer : buffers) {
+            if (!buffer->isNameWritten) {
+                fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                              "\"args\":{\"name\":\"%s\"}}", isFirstEvent ? "" : ",\n", buffer->threadNumber,
+                        buffer->threadName);
+                isFirstEvent = false;
+                buffer->isNameWritten = true;
+            }
+
+            buffer->drain([this, &buffer](const TraceEvent &event) { this->writeEvent(*buffer, event); });
+        }
+    }
+
+    // Drains the buffers every TRACE_FLUSH_INTERVAL until the trace is stopped, then drains them once more.
+    void TraceState::writerLoop() {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(stopMutex);
+                if (stopRequested.wait_for(lock, TRACE_FLUSH_INTERVAL, [this] { return isStopping; }))
+                    break;
+            }
+
+            this->writePending();
+        }
+
+        this->writePending();
+    }
+}
+
+// Starts writing a trace to the file at the given path, replacing it. Returns false if the file cannot
+//   be opened or a trace is already being written.
+bool Trace::start(const std::string &path) {
+    TraceState &state = traceState();
+    if (Trace::isRunning())
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.file = fopen(path.c_str(), "w");
+        if (!state.file)
+            return false;
+
+        // Throw away anything left over from an earlier trace.
+        for (auto &buffer : state.buffers) {
+            buffer->drain([](const TraceEvent &) {});
+            buffer->isNameWritten = false;
+            buffer->nDropped = 0;
+        }
+
+        fprintf(state.file, "{\"traceEvents\":[\n");
+        state.isFirstEvent = true;
+        state.startTime = std::chrono::steady_clock::now();
+        state.isStopping = false;
+    }
+
+    state.writer = std::thread(&TraceState::writerLoop, &state);
+    isTraceRunning.store(true, std::memory_order_release);
+
+    return true;
+}
+
+// Stops recording zones, writes everything that was recorded, and closes the file.
+void Trace::stop() {
+    TraceState &state = traceState();
+    if (!Trace::isRunning())
+        return;
+
+    isTraceRunning.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(state.stopMutex);
+        state.isStopping = true;
+    }
+    state.stopRequested.notify_all();
+    state.writer.join();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    unsigned long long nDropped = 0;
+    for (auto &buffer : state.buffers)
+        nDropped += buffer->nDropped.load();
+    fprintf(state.file, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":%llu}}\n", nDropped);
+    fclose(state.file);
+    state.file = nullptr;
+}
+
+// Names the calling thread in traces. The name is not copied, so it must be a string literal.
+void Trace::setThreadName(const char *name) {
+    threadName = name;
+
+    if (threadBuffer) {
+        TraceState &state = traceState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        threadBuffer->threadName = name;
+        threadBuffer->isNameWritten = false;
+    }
+}
+
+// Returns the number of nanoseconds since the trace was started.
+unsigned long long Trace::now() {
+    return (unsigned long long) std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - traceState().startTime).count();
+}
+
+// Adds a zone to the calling thread's buffer. The first zone a thread records creates its buffer.
+void Trace::record(const char *name, unsigned long long startNs, unsigned long long endNs) {
+    // A zone that started before the trace was restarted has a start time from the earlier trace.
+    if (endNs < startNs)
+        return;
+
+    if (!threadBuffer) {
+        TraceState &state = traceState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.buffers.emplace_back(new TraceThreadBuffer((uint) state.buffers.size() + 1,
+                                                         threadName ? threadName : "thread"));
+        threadBuffer = state.buffers.back().get();
+    }
+
+    threadBuffer->push(TraceEvent{name, startNs, endNs});
+}
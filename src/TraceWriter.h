@@ -0,0 +1,110 @@
+#ifndef WELT_TRACEWRITER_H
+#define WELT_TRACEWRITER_H
+
+#include "universal.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Define WELT_TRACE to compile in the trace zones marked with WELT_TRACE_ZONE. Without it, they expand to nothing.
+#ifdef WELT_TRACE
+#define WELT_TRACE_CONCAT_(a, b) a##b
+#define WELT_TRACE_CONCAT(a, b) WELT_TRACE_CONCAT_(a, b)
+#define WELT_TRACE_ZONE(name) TraceZone WELT_TRACE_CONCAT(traceZone, __LINE__)(name)
+#else
+#define WELT_TRACE_ZONE(name) do {} while (false)
+#endif
+
+// A zone that has ended. The name is not copied, so it must be a string literal.
+struct TraceEvent {
+    const char *name;
+    unsigned long long startNs, endNs; // Since the trace was started.
+};
+
+// The events recorded by one thread, waiting to be written. One thread pushes and the writer thread
+//   drains, through a fixed size ring indexed by two atomic counters, so neither ever waits for the other.
+//   If the ring is full, the event is dropped and counted.
+class TraceThreadBuffer {
+public:
+    TraceThreadBuffer(uint threadNumber, const char *threadName);
+
+    // Adds an event. Only called by the thread that owns the buffer.
+    void push(const TraceEvent &event) {
+        const uint head = nextWrite.load(std::memory_order_relaxed);
+        if (head - nextRead.load(std::memory_order_acquire) == events.size()) {
+            nDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        events[head & eventMask] = event;
+        nextWrite.store(head + 1, std::memory_order_release);
+    }
+
+    // Calls consume(const TraceEvent &) for every event pushed so far. Only called by the writer thread.
+    template<class Consume>
+    void drain(Consume &&consume) {
+        const uint head = nextWrite.load(std::memory_order_acquire);
+        uint tail = nextRead.load(std::memory_order_relaxed);
+        for (; tail != head; tail++)
+            consume(events[tail & eventMask]);
+        nextRead.store(tail, std::memory_order_release);
+    }
+
+    const uint threadNumber;
+    const char *threadName;       // Only changed while the trace's buffer list is locked.
+    bool isNameWritten;           // Only used by the writer thread.
+    std::atomic<unsigned long long> nDropped;
+
+private:
+    std::vector<TraceEvent> events;
+    uint eventMask;
+    std::atomic<uint> nextWrite, nextRead;
+};
+
+// Writes trace zones to a file in the Chrome trace event format, which chrome://tracing and the Perfetto
+//   UI can open. Zones are pushed to a buffer owned by the thread that recorded them, and a writer thread
+//   drains every buffer into the file in the background, so recording a zone never takes a lock or
+//   touches the file. Call stop before the program exits, or the end of the file is not written.
+class Trace {
+public:
+    static bool start(const std::string &path);
+
+    static void stop();
+
+    // Returns true if a trace is being written.
+    static bool isRunning() { return isTraceRunning.load(std::memory_order_acquire); }
+
+    static void setThreadName(const char *name);
+
+    static unsigned long long now();
+
+    static void record(const char *name, unsigned long long startNs, unsigned long long endNs);
+
+private:
+    static std::atomic<bool> isTraceRunning;
+};
+
+// Records the time from its creation to its destruction as a zone, if a trace is being written.
+//   Use it through WELT_TRACE_ZONE, so it can be compiled out.
+class TraceZone {
+public:
+    explicit TraceZone(const char *name) : name(name), isRecorded(Trace::isRunning()),
+                                           startNs(isRecorded ? Trace::now() : 0) {}
+
+    ~TraceZone() {
+        if (isRecorded)
+            Trace::record(name, startNs, Trace::now());
+    }
+
+    TraceZone(const TraceZone &) = delete;
+
+    TraceZone &operator=(const TraceZone &) = delete;
+
+private:
+    const char *name;
+    bool isRecorded;
+    unsigned long long startNs;
+};
+
+
+#endif //WELT_TRACEWRITER_H
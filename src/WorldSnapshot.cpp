@@ -0,0 +1,628 @@
+#include "WorldSnapshot.h"
+
+#include <cstring>
+
+const char SNAPSHOT_MAGIC[8] = {'W', 'E', 'L', 'T', 'S', 'N', 'A', 'P'};
+const uint32_t SNAPSHOT_BYTE_ORDER_MARK = 0x01020304;
+
+// Stored pages start at multiples of SNAPSHOT_PAGE_ALIGNMENT bytes, so they can be used from a mapping directly.
+const uint SNAPSHOT_PAGE_ALIGNMENT = 4096;
+const size_t SNAPSHOT_PAGE_BYTES = TILES_PER_PAGE * sizeof(Tile);
+
+// Marks pages that are not stored in the page table.
+const uint32_t SNAPSHOT_PAGE_NONE = 0xFFFFFFFF;
+
+// Returns the name of the entity's type, or nullptr if it is not registered.
+const std::string *SnapshotRegistry::entityTypeName(Ientity &entity) const {
+    const auto found = entityNames.find(std::type_index(typeid(entity)));
+    return (found == entityNames.end()) ? nullptr : &found->second;
+}
+
+// Returns the name of the item's type, or nullptr if it is not registered.
+const std::string *SnapshotRegistry::itemTypeName(Iitem &item) const {
+    const auto found = itemNames.find(std::type_index(typeid(item)));
+    return (found == itemNames.end()) ? nullptr : &found->second;
+}
+
+// Returns a new entity of the type with the given name, or nullptr if no type has that name.
+Ientity *SnapshotRegistry::createEntity(const std::string &name) const {
+    const auto found = entityFactories.find(name);
+    return (found == entityFactories.end()) ? nullptr : found->second();
+}
+
+// Returns a new item of the type with the given name, or nullptr if no type has that name.
+Iitem *SnapshotRegistry::createItem(const std::string &name) const {
+    const auto found = itemFactories.find(name);
+    return (found == itemFactories.end()) ? nullptr : found->second();
+}
+
+// The fixed part at the start of a snapshot file, followed by the page table.
+struct WorldSnapshot::Header {
+    uint32_t version, byteOrderMark, tileSize, tilePageBits, layoutID, width, height, nPages, nStoredPages, isPaged;
+    uint64_t pagesOffset, objectsOffset, objectsSize;
+    const uint32_t *pageTable; // Points into the file. The stored page number of every page, or SNAPSHOT_PAGE_NONE.
+};
+
+namespace {
+    // Returns value rounded up to a multiple of alignment.
+    uint64_t alignUp(uint64_t value, uint64_t alignment) {
+        return ((value + alignment - 1) / alignment) * alignment;
+    }
+
+    void writeMaterial(ByteWriter &writer, const Material &material) {
+        writer.writeU32((uint32_t) material.materialType);
+        writer.writeU32(material.baseHealth);
+        writer.writeU32(material.color);
+        writer.writeU32(material.defaultDisplayWall);
+        writer.writeU32(material.defaultDisplayFloor);
+    }
+
+    Material readMaterial(ByteReader &reader) {
+        Material material{};
+        material.materialType = (MaterialType) reader.readU32();
+        material.baseHealth = reader.readU32();
+        material.color = reader.readU32();
+        material.defaultDisplayWall = reader.readU32();
+        material.defaultDisplayFloor = reader.readU32();
+        return material;
+    }
+
+    // Writes the generation of every slot of a SlotMap, and its free list.
+    template<class Object, class ID_Type>
+    void writeSlots(ByteWriter &writer, SlotMap<Object, ID_Type> &store) {
+        writer.writeU32(store.slotCount());
+        for (uint i = 0; i < store.slotCount(); i++)
+            writer.writeU32(store.atSlot(i).generation);
+
+        writer.writeU32((uint32_t) store.freeSlotList().size());
+        for (uint slotIndex : store.freeSlotList())
+            writer.writeU32(slotIndex);
+    }
+
+    // Reads what writeSlots wrote into an empty SlotMap, and marks the free slots in isFree. Returns false if
+    //   it is not valid.
+    template<class Object, class ID_Type>
+    bool readSlots(ByteReader &reader, SlotMap<Object, ID_Type> &store, std::vector<bool> &isFree) {
+        std::vector<uint> generations(reader.readU32());
+        if (!reader.isValid() || (generations.size() > (size_t) SLOT_INDEX_MASK + 1))
+            return false;
+        for (uint &generation : generations)
+            generation = reader.readU32();
+
+        std::vector<uint> freeSlots(reader.readU32());
+        if (!reader.isValid() || (freeSlots.size() > generations.size()))
+            return false;
+        isFree.assign(generations.size(), false);
+        for (uint &slotIndex : freeSlots) {
+            slotIndex = reader.readU32();
+            if ((slotIndex >= generations.size()) || isFree[slotIndex])
+                return false;
+            isFree[slotIndex] = true;
+        }
+
+        if (!reader.isValid())
+            return false;
+        store.restoreSlots(generations, freeSlots);
+        return true;
+    }
+
+    // Returns true if every slot that is neither free nor occupied is retired. No other slot can be unused.
+    template<class Object, class ID_Type>
+    bool areUnusedSlotsRetired(SlotMap<Object, ID_Type> &store, const std::vector<bool> &isFree) {
+        for (uint i = 0; i < store.slotCount(); i++) {
+            if (!isFree[i] && !store.atSlot(i).isOccupied && !store.isRetired(i))
+                return false;
+        }
+
+        return true;
+    }
+
+    // Writes the lists of slot indices of a chunk index.
+    void writeChunkIndex(ByteWriter &writer, const vector<vector<uint>> &chunks) {
+        writer.writeU32((uint32_t) chunks.size());
+        for (const vector<uint> &chunk : chunks) {
+            writer.writeU32((uint32_t) chunk.size());
+            for (uint slotIndex : chunk)
+                writer.writeU32(slotIndex);
+        }
+    }
+
+    // Returns the index of the name in names, adding it if it is not there.
+    uint16_t typeIndexOf(vector<std::string> &names, const std::string &name) {
+        for (uint i = 0; i < names.size(); i++) {
+            if (names[i] == name)
+                return (uint16_t) i;
+        }
+
+        names.push_back(name);
+        return (uint16_t) (names.size() - 1);
+    }
+
+    void writeTypeNames(ByteWriter &writer, const vector<std::string> &names) {
+        writer.writeU32((uint32_t) names.size());
+        for (const std::string &name : names)
+            writer.writeString(name);
+    }
+
+    vector<std::string> readTypeNames(ByteReader &reader) {
+        vector<std::string> names;
+        const uint32_t nNames = reader.readU32();
+        for (uint i = 0; (i < nNames) && reader.isValid(); i++)
+            names.push_back(reader.readString());
+
+        return names;
+    }
+}
+
+// Saves the world to the file at the given path, replacing it. Returns true if successful. If not, the reason
+//   is stored in error, if it is given. Every entity and item must be of a type registered with the registry.
+//   Must not be called during a tick.
+bool WorldSnapshot::save(World &world, const std::string &path, const SnapshotRegistry &registry,
+                         std::string *error) {
+    std::string reason;
+    TileMap &map = *world.map;
+
+    ByteWriter objects;
+    if (!saveObjects(world, registry, objects, reason)) {
+        if (error)
+            *error = reason;
+        return false;
+    }
+
+    // Number the allocated pages in the order they are stored.
+    vector<uint32_t> pageTable(map.pages.size(), SNAPSHOT_PAGE_NONE);
+    uint32_t nStoredPages = 0;
+    for (uint i = 0; i < map.pages.size(); i++) {
+        if (map.pages[i])
+            pageTable[i] = nStoredPages++;
+    }
+
+    ByteWriter header;
+    header.writeBytes(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.writeU32(SNAPSHOT_VERSION);
+    header.writeU32(SNAPSHOT_BYTE_ORDER_MARK);
+    header.writeU32((uint32_t) sizeof(Tile));
+    header.writeU32(TILE_PAGE_BITS);
+    header.writeU32(DefaultGridLayout::LAYOUT_ID);
+    header.writeU32(map.width());
+    header.writeU32(map.height());
+    header.writeU32((uint32_t) pageTable.size());
+    header.writeU32(nStoredPages);
+    header.writeU32(map.isPaged() ? 1 : 0);
+
+    const uint64_t headerSize = header.size() + (3 * sizeof(uint64_t)) + (pageTable.size() * sizeof(uint32_t));
+    const uint64_t pagesOffset = alignUp(headerSize, SNAPSHOT_PAGE_ALIGNMENT);
+    const uint64_t objectsOffset = pagesOffset + (nStoredPages * SNAPSHOT_PAGE_BYTES);
+    header.writeU64(pagesOffset);
+    header.writeU64(objectsOffset);
+    header.writeU64(objects.size());
+    header.writeBytes(pageTable.data(), pageTable.size() * sizeof(uint32_t));
+    header.bytes().resize(pagesOffset, 0);
+
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file) {
+        if (error)
+            *error = "Could not open " + path + " for writing";
+        return false;
+    }
+
+    bool isWritten = fwrite(header.bytes().data(), 1, header.size(), file) == header.size();
+    for (uint i = 0; isWritten && (i < map.pages.size()); i++) {
+        if (map.pages[i])
+            isWritten = fwrite(map.pages[i], 1, SNAPSHOT_PAGE_BYTES, file) == SNAPSHOT_PAGE_BYTES;
+    }
+    isWritten = isWritten && (fwrite(objects.bytes().data(), 1, objects.size(), file) == objects.size());
+    isWritten = (fclose(file) == 0) && isWritten;
+
+    if (!isWritten && error)
+        *error = "Could not write " + path;
+    return isWritten;
+}
+
+// Writes everything but the tile pages: the world's counters, the materials and default tile of the
+//   TileMap, then the entities and the items with their slots and chunk indices.
+bool WorldSnapshot::saveObjects(World &world, const SnapshotRegistry &registry, ByteWriter &writer,
+                                std::string &error) {
+    TileMap &map = *world.map;
+
+    writer.writeU32(world.tickNumber);
+    writer.writeU32(world.givenEnergyPerTick);
+    writer.writeU32(world.chunkSize);
+    writer.writeU8(world.isTickParallel ? 1 : 0);
+
+    writer.writeU32(map.materials.size());
+    for (uint i = 0; i < map.materials.size(); i++)
+        writeMaterial(writer, map.materials.get((MaterialID) i));
+    writer.writeBytes(&map.defaultTile, sizeof(Tile));
+
+    // Find the entities waiting for a nearby change. The lists can hold entities that have since been
+    //   deleted or woken, which are left out.
+    vector<bool> isChangeSleeper(world.entitiesInWorld.slotCount(), false);
+    for (const vector<EID> &sleepers : world.changeSleepersInChunks) {
+        for (EID id : sleepers) {
+            if (world.entitiesInWorld.find(id) &&
+                (world.entityWakeTick[SlotMap<Ientity, EID>::slotIndexOf(id)] == TICK_NEVER))
+                isChangeSleeper[SlotMap<Ientity, EID>::slotIndexOf(id)] = true;
+        }
+    }
+
+    // Write the entities in the order of the dense array, so that it is the same once loaded.
+    vector<std::string> entityTypes;
+    ByteWriter entities, state;
+    for (uint i = 0; i < world.entitiesInWorld.size(); i++) {
+        const uint slotIndex = world.entitiesInWorld.denseSlot(i);
+        ObjectAndData<Ientity, EID> &entityData = world.entitiesInWorld.atSlot(slotIndex).data;
+        const std::string *typeName = registry.entityTypeName(entityData.object());
+        if (!typeName) {
+            error = std::string("An entity's type is not registered: ") + typeid(entityData.object()).name();
+            return false;
+        }
+
+        state.bytes().clear();
+        entityData.object().saveState(state);
+
+        entities.writeU32(slotIndex);
+        entities.writeU32(entityData.coordinate().x);
+        entities.writeU32(entityData.coordinate().y);
+        entities.writeU16(typeIndexOf(entityTypes, *typeName));
+        entities.writeU32(world.entityWakeTick[slotIndex]);
+        entities.writeU32(world.entityLastTick[slotIndex]);
+        entities.writeU8(isChangeSleeper[slotIndex] ? 1 : 0);
+        entities.writeU32((uint32_t) state.size());
+        entities.writeBytes(state.bytes().data(), state.size());
+    }
+
+    writeTypeNames(writer, entityTypes);
+    writeSlots(writer, world.entitiesInWorld);
+    writer.writeU32(world.entitiesInWorld.size());
+    writer.writeBytes(entities.bytes().data(), entities.size());
+    writeChunkIndex(writer, world.entitiesInChunks);
+
+    // Write the items of each tile oldest first, so that adding them in order rebuilds the same lists.
+    vector<std::string> itemTypes;
+    ByteWriter items;
+    vector<uint> tileItems;
+    for (uint i = 0; i < world.itemsInWorld.size(); i++) {
+        const uint headSlot = world.itemsInWorld.denseSlot(i);
+        const Coordinate cord = world.itemsInWorld.atSlot(headSlot).data.coordinate();
+        if (world.firstItemOnTile.get(cord) != headSlot)
+            continue;
+
+        tileItems.clear();
+        for (uint slotIndex = headSlot; slotIndex != SLOT_NONE; slotIndex = world.nextItemOnTile[slotIndex])
+            tileItems.push_back(slotIndex);
+
+        for (auto slot = tileItems.rbegin(); slot != tileItems.rend(); ++slot) {
+            ObjectAndData<Iitem, IID> &itemData = world.itemsInWorld.atSlot(*slot).data;
+            const std::string *typeName = registry.itemTypeName(itemData.object());
+            if (!typeName) {
+                error = std::string("An item's type is not registered: ") + typeid(itemData.object()).name();
+                return false;
+            }
+
+            state.bytes().clear();
+            itemData.object().saveState(state);
+
+            items.writeU32(*slot);
+            items.writeU32(cord.x);
+            items.writeU32(cord.y);
+            items.writeU16(typeIndexOf(itemTypes, *typeName));
+            items.writeU32((uint32_t) state.size());
+            items.writeBytes(state.bytes().data(), state.size());
+        }
+    }
+
+    writeTypeNames(writer, itemTypes);
+    writeSlots(writer, world.itemsInWorld);
+    writer.writeU32(world.itemsInWorld.size());
+    writer.writeBytes(items.bytes().data(), items.size());
+    writeChunkIndex(writer, world.itemsInChunks);
+
+    return true;
+}
+
+// Loads a World from the snapshot file at the given path. Returns nullptr if the file cannot be read or is not
+//   a valid snapshot, and stores the reason in error, if it is given. Every entity and item type in the
+//   snapshot must be registered with the registry.
+std::unique_ptr<World> WorldSnapshot::load(const std::string &path, const SnapshotRegistry &registry,
+                                           std::string *error) {
+    std::string reason;
+    std::unique_ptr<World> world;
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+
+    // Reads the header, creates the World, and fills it. Returns false with a reason if anything is wrong.
+    auto loadWorld = [&]() -> bool {
+        if (!file->open(path)) {
+            reason = "Could not open " + path;
+            return false;
+        }
+
+        ByteReader headerReader(file->data(), file->size());
+        const uint8_t *magic = headerReader.readBytes(sizeof(SNAPSHOT_MAGIC));
+        if (!magic || (memcmp(magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)) {
+            reason = path + " is not a world snapshot";
+            return false;
+        }
+
+        Header header{};
+        header.version = headerReader.readU32();
+        header.byteOrderMark = headerReader.readU32();
+        if ((header.version != SNAPSHOT_VERSION) || (header.byteOrderMark != SNAPSHOT_BYTE_ORDER_MARK)) {
+            reason = "The snapshot is of another version, or from a machine with another byte order";
+            return false;
+        }
+
+        header.tileSize = headerReader.readU32();
+        header.tilePageBits = headerReader.readU32();
+        header.layoutID = headerReader.readU32();
+        header.width = headerReader.readU32();
+        header.height = headerReader.readU32();
+        header.nPages = headerReader.readU32();
+        header.nStoredPages = headerReader.readU32();
+        header.isPaged = headerReader.readU32();
+        header.pagesOffset = headerReader.readU64();
+        header.objectsOffset = headerReader.readU64();
+        header.objectsSize = headerReader.readU64();
+        header.pageTable = (const uint32_t *) headerReader.readBytes(header.nPages * sizeof(uint32_t));
+        if (!headerReader.isValid() || (header.tileSize != sizeof(Tile)) || (header.tilePageBits != TILE_PAGE_BITS) ||
+            (header.width == 0) || (header.height == 0) || (header.isPaged > 1) ||
+            (header.pagesOffset % SNAPSHOT_PAGE_ALIGNMENT != 0) ||
+            (header.objectsOffset != header.pagesOffset + (header.nStoredPages * SNAPSHOT_PAGE_BYTES)) ||
+            (header.objectsOffset > file->size()) || (header.objectsSize > file->size() - header.objectsOffset)) {
+            reason = "The snapshot header is not valid";
+            return false;
+        }
+
+        ByteReader reader(file->data() + header.objectsOffset, header.objectsSize);
+        const uint tickNumber = reader.readU32();
+        const uint energyPerTick = reader.readU32();
+        const uint chunkSize = reader.readU32();
+        const bool isTickParallel = reader.readU8() != 0;
+
+        world.reset(new World(header.height, header.width, energyPerTick, true));
+        if (!reader.isValid() || (chunkSize != world->chunkSize)) {
+            reason = "The snapshot's chunk size does not match";
+            return false;
+        }
+        world->tickNumber = tickNumber;
+        world->setParallelTick(isTickParallel);
+        if (!loadTiles(*world, header, file, reader, reason))
+            return false;
+
+        // The World is created paged, so that its pages can be borrowed from the file. If it was not paged
+        //   when saved, it is given the rest of its pages, and its occupancy layers in full, once they are.
+        if (!header.isPaged) {
+            TileMap &map = *world->map;
+            for (uint i = 0; i < map.pages.size(); i++)
+                map.allocatePage(i);
+            map._isPaged = false;
+            world->entityOnTile.allocateAll();
+            world->firstItemOnTile.allocateAll();
+            world->isTileDirty.allocateAll();
+        }
+
+        return loadObjects(*world, header, reader, registry, reason);
+    };
+
+    try {
+        if (loadWorld())
+            return world;
+    } catch (std::exception &exception) {
+        reason = std::string("Could not load the snapshot: ") + exception.what();
+    }
+
+    if (error)
+        *error = reason;
+    return nullptr;
+}
+
+// Restores the materials and the default tile, and gives the TileMap its pages. If the snapshot uses the
+//   same layout, the pages are borrowed from the mapped file. If not, they are copied into the new layout.
+bool WorldSnapshot::loadTiles(World &world, const Header &header, const std::shared_ptr<MappedFile> &file,
+                              ByteReader &reader, std::string &error) {
+    TileMap &map = *world.map;
+
+    // Intern the materials in their saved order, so every MaterialID in the tiles keeps its meaning.
+    const uint32_t nMaterials = reader.readU32();
+    for (uint i = 0; (i < nMaterials) && reader.isValid(); i++) {
+        if (map.materials.intern(readMaterial(reader)) != i) {
+            error = "The snapshot's materials are not valid";
+            return false;
+        }
+    }
+
+    const uint8_t *defaultTile = reader.readBytes(sizeof(Tile));
+    if (!reader.isValid() || (header.nPages != map.pages.size())) {
+        error = "The snapshot's tiles are not valid";
+        return false;
+    }
+    memcpy(&map.defaultTile, defaultTile, sizeof(Tile));
+
+    const bool isLayoutSame = header.layoutID == DefaultGridLayout::LAYOUT_ID;
+    for (uint pageNumber = 0; pageNumber < header.nPages; pageNumber++) {
+        const uint32_t storedPage = header.pageTable[pageNumber];
+        if (storedPage == SNAPSHOT_PAGE_NONE)
+            continue;
+        if (storedPage >= header.nStoredPages) {
+            error = "The snapshot's page table is not valid";
+            return false;
+        }
+
+        Tile *tiles = (Tile *) (file->data() + header.pagesOffset + (storedPage * SNAPSHOT_PAGE_BYTES));
+        if (isLayoutSame) {
+            map.borrowPage(pageNumber, tiles);
+            continue;
+        }
+
+        // Move every tile from its place in the saved layout to its place in this one.
+        Tile *page = map.allocatePage(pageNumber);
+        for (uint y = 0; y <= TILE_PAGE_MASK; y++) {
+            for (uint x = 0; x <= TILE_PAGE_MASK; x++) {
+                const uint savedIndex = (header.layoutID == MortonLayout::LAYOUT_ID)
+                                        ? MortonLayout::indexInSquare(x, y, TILE_PAGE_BITS)
+                                        : RowMajorLayout::indexInSquare(x, y, TILE_PAGE_BITS);
+                page[DefaultGridLayout::indexInSquare(x, y, TILE_PAGE_BITS)] = tiles[savedIndex];
+            }
+        }
+    }
+
+    // Keep the file mapped for as long as the TileMap uses its pages.
+    if (isLayoutSame)
+        map.borrowedStorage = file;
+
+    return true;
+}
+
+// Creates the entities and items in the slots they had, and restores their chunk indices and the wake schedule.
+bool WorldSnapshot::loadObjects(World &world, const Header &header, ByteReader &reader,
+                                const SnapshotRegistry &registry, std::string &error) {
+    TileMap &map = *world.map;
+    const bool isLayoutSame = header.layoutID == DefaultGridLayout::LAYOUT_ID;
+    error = "The snapshot's entities are not valid";
+
+    const vector<std::string> entityTypes = readTypeNames(reader);
+    vector<bool> isFree;
+    if (!reader.isValid() || !readSlots(reader, world.entitiesInWorld, isFree))
+        return false;
+
+    const uint nSlots = world.entitiesInWorld.slotCount();
+    world.entityTypeOfSlot.assign(nSlots, 0);
+    world.entityWakeTick.assign(nSlots, TICK_NEVER);
+    world.entityLastTick.assign(nSlots, 0);
+
+    const uint32_t nEntities = reader.readU32();
+    for (uint i = 0; (i < nEntities) && reader.isValid(); i++) {
+        const uint slotIndex = reader.readU32();
+        const Coordinate cord = Coordinate{reader.readU32(), reader.readU32()};
+        const uint16_t typeIndex = reader.readU16();
+        const uint wakeTick = reader.readU32();
+        const uint lastTick = reader.readU32();
+        const bool isChangeSleeper = reader.readU8() != 0;
+        const uint32_t stateSize = reader.readU32();
+        const uint8_t *state = reader.readBytes(stateSize);
+        if (!reader.isValid() || (typeIndex >= entityTypes.size()) || (slotIndex >= nSlots) || isFree[slotIndex] ||
+            world.entitiesInWorld.atSlot(slotIndex).isOccupied || cordOutsideBound(map.maxCord(), cord) ||
+            (world.entityOnTile.get(cord) != SLOT_NONE))
+            return false;
+
+        // The entity is owned here until the World holds it.
+        std::unique_ptr<Ientity> entity(registry.createEntity(entityTypes[typeIndex]));
+        if (!entity) {
+            error = "An entity type in the snapshot is not registered: " + entityTypes[typeIndex];
+            return false;
+        }
+
+        ByteReader stateReader(state, stateSize);
+        if (!entity->loadState(stateReader) || !stateReader.isValid())
+            return false;
+
+        world.entityTypeOfSlot[slotIndex] = entity->getObjectType();
+        const EID id = world.entitiesInWorld.insertAt(slotIndex, entity.get(), &world.isDataLocked, cord);
+        entity.release();
+        const uint chunkNumber = world.getChunkNumberForCoordinate(cord);
+        world.entityOnTile.set(cord, slotIndex);
+        world.adjustChunkPopulation(chunkNumber, world.entityTypeOfSlot[slotIndex], 1);
+        world.entityLastTick[slotIndex] = lastTick;
+        world.entityWakeTick[slotIndex] = wakeTick;
+        if (wakeTick != TICK_NEVER)
+            world.wakeWheel.schedule(id, wakeTick);
+        else if (isChangeSleeper)
+            world.changeSleepersInChunks[chunkNumber].push_back(id);
+
+        // Without the saved chunk index, entities are added to their chunks in the order they are loaded.
+        if (!isLayoutSame) {
+            SlotMap<Ientity, EID>::Slot &slot = world.entitiesInWorld.atSlot(slotIndex);
+            world.addToChunk(world.entitiesInChunks[chunkNumber], slot.chunkPosition, slotIndex);
+        }
+    }
+
+    // The saved chunk index keeps the order of the entities in each chunk. It is only valid for the same layout.
+    const uint32_t nEntityChunks = reader.readU32();
+    if (!reader.isValid() || !areUnusedSlotsRetired(world.entitiesInWorld, isFree) ||
+        (isLayoutSame && (nEntityChunks != world.entitiesInChunks.size())))
+        return false;
+    uint nIndexed = 0;
+    for (uint chunkNumber = 0; (chunkNumber < nEntityChunks) && reader.isValid(); chunkNumber++) {
+        const uint32_t nInChunk = reader.readU32();
+        for (uint i = 0; (i < nInChunk) && reader.isValid(); i++) {
+            const uint slotIndex = reader.readU32();
+            if (!isLayoutSame)
+                continue;
+
+            if ((slotIndex >= nSlots) || !world.entitiesInWorld.atSlot(slotIndex).isOccupied ||
+                (world.getChunkNumberForCoordinate(world.entitiesInWorld.atSlot(slotIndex).data.coordinate()) !=
+                 chunkNumber))
+                return false;
+            world.addToChunk(world.entitiesInChunks[chunkNumber], world.entitiesInWorld.atSlot(slotIndex).chunkPosition,
+                             slotIndex);
+            nIndexed++;
+        }
+    }
+    if (!reader.isValid() || (isLayoutSame && (nIndexed != world.entitiesInWorld.size())))
+        return false;
+
+    // Load the items the same way.
+    error = "The snapshot's items are not valid";
+    const vector<std::string> itemTypes = readTypeNames(reader);
+    if (!reader.isValid() || !readSlots(reader, world.itemsInWorld, isFree))
+        return false;
+
+    const uint nItemSlots = world.itemsInWorld.slotCount();
+    const uint32_t nItems = reader.readU32();
+    for (uint i = 0; (i < nItems) && reader.isValid(); i++) {
+        const uint slotIndex = reader.readU32();
+        const Coordinate cord = Coordinate{reader.readU32(), reader.readU32()};
+        const uint16_t typeIndex = reader.readU16();
+        const uint32_t stateSize = reader.readU32();
+        const uint8_t *state = reader.readBytes(stateSize);
+        if (!reader.isValid() || (typeIndex >= itemTypes.size()) || (slotIndex >= nItemSlots) || isFree[slotIndex] ||
+            world.itemsInWorld.atSlot(slotIndex).isOccupied || cordOutsideBound(map.maxCord(), cord))
+            return false;
+
+        std::unique_ptr<Iitem> item(registry.createItem(itemTypes[typeIndex]));
+        if (!item) {
+            error = "An item type in the snapshot is not registered: " + itemTypes[typeIndex];
+            return false;
+        }
+
+        ByteReader stateReader(state, stateSize);
+        if (!item->loadState(stateReader) || !stateReader.isValid())
+            return false;
+
+        world.itemsInWorld.insertAt(slotIndex, item.get(), &world.isDataLocked, cord);
+        item.release();
+        world.linkItemToTile(slotIndex, cord);
+        if (!isLayoutSame) {
+            SlotMap<Iitem, IID>::Slot &slot = world.itemsInWorld.atSlot(slotIndex);
+            world.addToChunk(world.itemsInChunks[world.getChunkNumberForCoordinate(cord)], slot.chunkPosition,
+                             slotIndex);
+        }
+    }
+
+    const uint32_t nItemChunks = reader.readU32();
+    if (!reader.isValid() || !areUnusedSlotsRetired(world.itemsInWorld, isFree) ||
+        (isLayoutSame && (nItemChunks != world.itemsInChunks.size())))
+        return false;
+    nIndexed = 0;
+    for (uint chunkNumber = 0; (chunkNumber < nItemChunks) && reader.isValid(); chunkNumber++) {
+        const uint32_t nInChunk = reader.readU32();
+        for (uint i = 0; (i < nInChunk) && reader.isValid(); i++) {
+            const uint slotIndex = reader.readU32();
+            if (!isLayoutSame)
+                continue;
+
+            if ((slotIndex >= nItemSlots) || !world.itemsInWorld.atSlot(slotIndex).isOccupied ||
+                (world.getChunkNumberForCoordinate(world.itemsInWorld.atSlot(slotIndex).data.coordinate()) !=
+                 chunkNumber))
+                return false;
+            world.addToChunk(world.itemsInChunks[chunkNumber], world.itemsInWorld.atSlot(slotIndex).chunkPosition,
+                             slotIndex);
+            nIndexed++;
+        }
+    }
+    if (!reader.isValid() || (isLayoutSame && (nIndexed != world.itemsInWorld.size())))
+        return false;
+
+    error.clear();
+    return true;
+}
@@ -0,0 +1,83 @@
+#ifndef WELT_WORLDSNAPSHOT_H
+#define WELT_WORLDSNAPSHOT_H
+
+#include "world.h"
+#include "ByteStream.h"
+#include "MappedFile.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+
+// The version of the snapshot format written by WorldSnapshot::save. Bump it when the format changes.
+const uint SNAPSHOT_VERSION = 1;
+
+// Makes the entities and items of the types registered with it, for loading snapshots. Each type is saved
+//   under a name, which must not change between the program that saves a snapshot and the one that loads it.
+//   The state of each object is saved and loaded by its saveState and loadState functions.
+class SnapshotRegistry {
+public:
+    template<class EntityType>
+    void registerEntity(const std::string &name, std::function<Ientity *()> create = [] { return new EntityType; }) {
+        entityNames[std::type_index(typeid(EntityType))] = name;
+        entityFactories[name] = create;
+    }
+
+    template<class ItemType>
+    void registerItem(const std::string &name, std::function<Iitem *()> create = [] { return new ItemType; }) {
+        itemNames[std::type_index(typeid(ItemType))] = name;
+        itemFactories[name] = create;
+    }
+
+    const std::string *entityTypeName(Ientity &entity) const;
+
+    const std::string *itemTypeName(Iitem &item) const;
+
+    Ientity *createEntity(const std::string &name) const;
+
+    Iitem *createItem(const std::string &name) const;
+
+private:
+    std::unordered_map<std::type_index, std::string> entityNames, itemNames;
+    std::unordered_map<std::string, std::function<Ientity *()>> entityFactories;
+    std::unordered_map<std::string, std::function<Iitem *()>> itemFactories;
+};
+
+// Saves a World to a binary file, and loads it back.
+//
+// A snapshot holds the tiles, the material registry, every entity and item with its handle, the chunk index,
+//   and the state of the entities' wake schedule, so a loaded World ticks on exactly as the saved one would
+//   have. It starts with a header and a table of the TileMap's pages, followed by every allocated page as
+//   raw tiles, each aligned to 4096 bytes. Pages that were never allocated are not stored. A World whose
+//   TileMap was paged is loaded paged, and any other World is loaded with every page allocated.
+//
+// Loading maps the file into memory, and the TileMap borrows its pages straight from the mapping, so
+//   opening a snapshot costs about the same however large the map is. Tiles are only read from disk when
+//   they are first used, and are copied in memory when first changed. The file itself is never changed.
+//   If the snapshot was saved with a different grid layout, the pages are copied and converted instead.
+//
+// Snapshots are written in the byte order of the machine, and can only be loaded on a machine with
+//   the same byte order.
+class WorldSnapshot {
+public:
+    static bool save(World &world, const std::string &path, const SnapshotRegistry &registry,
+                     std::string *error = nullptr);
+
+    static std::unique_ptr<World> load(const std::string &path, const SnapshotRegistry &registry,
+                                       std::string *error = nullptr);
+
+private:
+    struct Header;
+
+    static bool saveObjects(World &world, const SnapshotRegistry &registry, ByteWriter &writer, std::string &error);
+
+    static bool loadTiles(World &world, const Header &header, const std::shared_ptr<MappedFile> &file,
+                          ByteReader &reader, std::string &error);
+
+    static bool loadObjects(World &world, const Header &header, ByteReader &reader, const SnapshotRegistry &registry,
+                            std::string &error);
+};
+
+
+#endif //WELT_WORLDSNAPSHOT_H
@@ -3,7 +3,6 @@
 
 #include "DisplayIDdef.h"
 #include "universal.h"
-#include <SDL.h>
 
 enum MaterialType {
     SOLID,
@@ -11,6 +10,18 @@ enum MaterialType {
     LIQUID
 };
 
+// A set of MaterialTypes that an entity can move through, with one bit per MaterialType.
+typedef uint PassabilityRule;
+
+const PassabilityRule PASS_SOLID  = 1u << MaterialType::SOLID;
+const PassabilityRule PASS_GAS    = 1u << MaterialType::GAS;
+const PassabilityRule PASS_LIQUID = 1u << MaterialType::LIQUID;
+
+// Returns true if the given rule allows moving through the given MaterialType.
+inline bool canPass(PassabilityRule rule, MaterialType type) {
+    return (rule & (1u << type)) != 0;
+}
+
 struct Material {
     MaterialType materialType;  // Type of the material.
     uint baseHealth;            // The base health any wall of the specified material will have.
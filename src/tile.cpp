@@ -3,10 +3,10 @@
 
 Tile::Tile() {
     // Initialize the wall health with the default value.
-    wallMaterial= M_AIR;
-    floorMaterial= M_AIR;
-    wallDisplay= M_AIR.defaultDisplayWall;
-    floorDisplay= M_AIR.defaultDisplayFloor;
+    wallMaterial= MATERIAL_ID_AIR;
+    floorMaterial= MATERIAL_ID_AIR;
+    wallDisplay= (uint8_t) M_AIR.defaultDisplayWall;
+    floorDisplay= (uint8_t) M_AIR.defaultDisplayFloor;
     wallHealth = 0;
 }
 
@@ -2,15 +2,21 @@
 #define TILE_H
 
 #include "material.h"
+#include "MaterialRegistry.h"
+#include <cstdint>
 
+// A tile packed into 8 bytes. Materials are stored as IDs from the TileMap's MaterialRegistry,
+//   and DisplayIDs must fit in 8 bits.
 class Tile {
 public:
     Tile();
     ~Tile() = default;
 
-    DisplayID wallDisplay, floorDisplay;
-    Material wallMaterial, floorMaterial;
-    uint wallHealth;
+    MaterialID wallMaterial, floorMaterial;
+    uint16_t wallHealth;
+    uint8_t wallDisplay, floorDisplay;
 };
 
+static_assert(sizeof(Tile) == 8, "Tile should be packed into 8 bytes");
+
 #endif
\ No newline at end of file
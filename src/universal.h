@@ -2,11 +2,11 @@
 #define UNIVERSAL_H
 
 #include <list>
-#include <SDL.h>
 #include <string>
 #include <vector>
 #include <cmath>
-#include "../examples/01-Wolf_and_Sheep/LTexture.h"
+#include <cstdint>
+#include <cstdio>
 
 // ---------------- Typedefs ----------------
 typedef unsigned int DisplayID;
@@ -50,6 +50,14 @@ enum class DamageType {
     KINETIC,
 };
 
+enum class MoveResult {
+    MOVED,          // The entity was moved.
+    OUTSIDE_WORLD,  // The destination is outside the world.
+    BLOCKED,        // The destination's wall material cannot be passed.
+    OCCUPIED,       // Another entity is on the destination.
+    NOT_FOUND       // The entity is not in the world, or the given data is out of date.
+};
+
 // ---------------- Functions ----------------
 
 // If the given coordinate is outside the given bound (defined by its max coordinate,) the function returns true.
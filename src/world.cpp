@@ -1,39 +1,52 @@
 #include "world.h"
+#include "DeltaJournal.h"
 
 #include <memory>
 
 
-World::World(uint height, uint width, uint energyPerTick = 100) {
+World::World(uint height, uint width, uint energyPerTick = 100, bool isMapPaged) {
     // Make sure the World has valid dimensions. If something is wrong, throw invalid_argument.
     if ((height == 0) || (width == 0))
         throw invalid_argument("Cannot create a World with any dimension that is zero");
 
     // Create the tiles in the World. If enough memory cannot be allocated, throw bad_alloc.
     try {
-        map = new TileMap(height, width);
+        map = new TileMap(height, width, isMapPaged);
     } catch (bad_alloc &bad) {
         throw bad;
     }
 
-    // Start the OID, IID, and tick counters.
-    nextAvailableOID = 0;
-    nextAvailableIID = 0;
+    // Start the tick counter.
     tickNumber = 0;
     chunkSize = 16;
 
-    // Initialize the entity and item chunks and calculate the max chunk number.
-    const uint nChunksPerRow = (uint) ceil((double) width / (double) chunkSize);
-    Coordinate maxChunkCord;
-    maxChunkCord.y = height / chunkSize;
-    maxChunkCord.x = width / chunkSize;
-    maxChunkNumber = (maxChunkCord.y * nChunksPerRow) + maxChunkCord.x;
+    // Initialize the entity and item chunks and calculate the max chunk number. The chunk grid is
+    //   laid out by DefaultGridLayout, which may leave some chunk numbers unused.
+    nChunksPerRow = (uint) ceil((double) width / (double) chunkSize);
+    nChunkRows = (height / chunkSize) + 1;
+    maxChunkNumber = DefaultGridLayout::cellCount(nChunksPerRow, nChunkRows) - 1;
     entitiesInChunks.resize(maxChunkNumber + 1);
+    entityTypeCountsInChunks.resize(maxChunkNumber + 1);
     itemsInChunks.resize(maxChunkNumber + 1);
+    changeSleepersInChunks.resize(maxChunkNumber + 1);
+    isChunkChanged.assign(maxChunkNumber + 1, false);
+
+    // Initialize the occupancy layers. Every tile starts empty. Like the TileMap, the layers of a paged
+    //   World only allocate a page once something is placed in it. The chunk tables above are not paged,
+    //   but only take one entry per chunk.
+    entityOnTile.reset(width, height, SLOT_NONE, isMapPaged);
+    firstItemOnTile.reset(width, height, SLOT_NONE, isMapPaged);
+    isTileDirty.reset(width, height, false, isMapPaged);
+    isDisplayStale = true;
+    lastDisplayData = nullptr;
 
     // Set the energy to be given to every entity per tick.
     givenEnergyPerTick = energyPerTick;
 
     isDataLocked = true;
+    isTickParallel = false;
+    journal = nullptr;
+    this->setWorkerCount();
 
     assert(chunkSize != 0);
     assert(width != 0);
@@ -42,14 +55,18 @@ World::World(uint height, uint width, uint energyPerTick = 100) {
 }
 
 World::~World() {
+    // Stop recording before anything the journal uses is gone.
+    if (journal)
+        journal->stop();
+
     // Delete the TileMap.
     delete map;
 
-    for (auto entity : entitiesInWorld)
-        delete &entity.object();
+    for (uint i = 0; i < entitiesInWorld.size(); i++)
+        delete &entitiesInWorld.atSlot(entitiesInWorld.denseSlot(i)).data.object();
 
-    for (auto item : itemsInWorld)
-        delete &item.object();
+    for (uint i = 0; i < itemsInWorld.size(); i++)
+        delete &itemsInWorld.atSlot(itemsInWorld.denseSlot(i)).data.object();
 }
 
 // Returns a pointer to the TileMap used by the world.
@@ -57,126 +74,551 @@ TileMap *World::getMap() {
     return map;
 }
 
-// Loads a preexisting DisplayArray with all the data needed to display the world.
+// Loads a preexisting DisplayArray with all the data needed to display the world. If it is the same
+//   DisplayArray as last time, only the tiles that changed since then are loaded, so a world where
+//   little happens costs almost nothing to display.
 void World::loadDisplayArray(DisplayArray &displayArray) {
+    WELT_TRACE_ZONE("World::loadDisplayArray");
+    const bool isPatchable = !isDisplayStale && displayArray.displayData &&
+                             (displayArray.displayData == lastDisplayData) &&
+                             (displayArray.height == map->height()) && (displayArray.width == map->width()) &&
+                             !map->allTilesChanged();
+
+    if (isPatchable) {
+        for (uint tileIndex : map->changedTiles())
+            this->loadDisplayElement(displayArray, tileIndex);
+        for (uint tileIndex : dirtyTiles)
+            this->loadDisplayElement(displayArray, tileIndex);
+    } else {
+        this->loadAllDisplayElements(displayArray);
+        lastDisplayData = displayArray.displayData;
+        isDisplayStale = false;
+    }
 
-    // Load the DisplayArray with the info for the tiles.
-    map->loadDisplayArray(displayArray);
-
-    // Scan through and load all items' info into the DisplayArray.
-    for (auto &itemData : itemsInWorld) {
-        if (!cordOutsideBound(map->maxCord(), itemData.coordinate())) {
-            DisplayArrayElement &tmp = displayArray.displayData[getArrayIndex(itemData.coordinate(),
-                                                                              displayArray.width)];
+    map->clearChangedTiles();
+    this->clearDirtyTiles();
+}
 
-            tmp.ForegroundInfo = itemData.object().getDisplayID();
-            tmp.ForegroundColor = itemData.object().getMaterial().color;
+// Loads only the part of the world inside the view into a DisplayArray the size of the view, so the cost
+//   depends on the size of the view rather than the size of the world. The view is clipped to the world.
+//   Element (0, 0) of the DisplayArray is the tile at the view's top left corner.
+void World::loadDisplayArray(DisplayArray &displayArray, const ViewRect &view) {
+    WELT_TRACE_ZONE("World::loadDisplayArray");
+    const ViewRect clippedView = clipViewRect(view, map->width(), map->height());
+
+    // The DisplayArray no longer holds the whole world, so it cannot be patched by the other loadDisplayArray.
+    if (displayArray.displayData == lastDisplayData)
+        lastDisplayData = nullptr;
+
+    resizeDisplayArray(displayArray, clippedView.width, clippedView.height);
+    if ((clippedView.width == 0) || (clippedView.height == 0))
+        return;
+
+    scheduler->parallelFor(0, clippedView.height, ROWS_PER_TASK,
+                           [this, &displayArray, &clippedView](uint begin, uint end, uint) {
+                               map->loadDisplayArrayRows(displayArray, clippedView, begin, end);
+                           });
+
+    // Visit only the chunks that overlap the view. Each row of chunks covers different tiles, so rows
+    //   of chunks can be loaded at the same time.
+    const uint firstChunkColumn = clippedView.x / chunkSize;
+    const uint endChunkColumn = ((clippedView.x + clippedView.width - 1) / chunkSize) + 1;
+    const uint firstChunkRow = clippedView.y / chunkSize;
+    const uint endChunkRow = ((clippedView.y + clippedView.height - 1) / chunkSize) + 1;
+
+    scheduler->parallelFor(firstChunkRow, endChunkRow, 1, [&](uint begin, uint end, uint) {
+        for (uint chunkRow = begin; chunkRow < end; chunkRow++) {
+            for (uint chunkColumn = firstChunkColumn; chunkColumn < endChunkColumn; chunkColumn++) {
+                const uint chunk = DefaultGridLayout::cellNumber(chunkColumn, chunkRow, nChunksPerRow);
+
+                for (uint slotIndex : itemsInChunks[chunk]) {
+                    const Coordinate &cord = itemsInWorld.atSlot(slotIndex).data.coordinate();
+                    if (cordInsideView(clippedView, cord) &&
+                        (firstItemOnTile.get(cord) == slotIndex)) {
+                        DisplayArrayElement &tmp = displayArray.displayData[getIndexInView(clippedView, cord)];
+                        Iitem &item = itemsInWorld.atSlot(slotIndex).data.object();
+                        tmp.ForegroundInfo = item.getDisplayID();
+                        tmp.ForegroundColor = item.getMaterial().color;
+                    }
+                }
+
+                for (uint slotIndex : entitiesInChunks[chunk]) {
+                    const Coordinate &cord = entitiesInWorld.atSlot(slotIndex).data.coordinate();
+                    if (cordInsideView(clippedView, cord)) {
+                        DisplayArrayElement &tmp = displayArray.displayData[getIndexInView(clippedView, cord)];
+                        Ientity &entity = entitiesInWorld.atSlot(slotIndex).data.object();
+                        tmp.ForegroundInfo = entity.getDisplayID();
+                        tmp.ForegroundColor = entity.getMaterial().color;
+                    }
+                }
+            }
         }
+    });
+}
+
+// Loads a level of the TileMap's overview into a DisplayArray the size of that level. See
+//   TileMap::loadOverview.
+void World::loadOverview(DisplayArray &displayArray, uint level) {
+    map->loadOverview(displayArray, level);
+}
+
+// Loads the number of entities in each cell of a level of the overview. Cells line up with the elements
+//   loaded by loadOverview. The counts are built by the first call and kept up to date as entities are
+//   added, moved, and deleted. If the level does not exist, the top level is loaded.
+void World::loadEntityDensity(DensityArray &densityArray, uint level) {
+    if (entityDensity.isEmpty()) {
+        entityDensity.resize(map->width(), map->height(), 0);
+        for (uint i = 0; i < entitiesInWorld.size(); i++)
+            this->adjustEntityDensity(entitiesInWorld.atSlot(entitiesInWorld.denseSlot(i)).data.coordinate(), 1);
     }
 
-    // Scan through and load all entities' info into the DisplayArray.
-    for (auto &entityData : entitiesInWorld) {
-        if (!cordOutsideBound(map->maxCord(), entityData.coordinate())) {
-            DisplayArrayElement &tmp = displayArray.displayData[getArrayIndex(entityData.coordinate(),
-                                                                              displayArray.width)];
+    entityDensity.refresh([](const uint *children, uint nChildren) {
+        uint sum = 0;
+        for (uint i = 0; i < nChildren; i++)
+            sum += children[i];
+        return sum;
+    });
+
+    // Only entities are counted, so the top level must add up to the number of entities in the World.
+    const uint topLevel = entityDensity.levelCount() - 1;
+    const uint *topCounts = entityDensity.levelData(topLevel);
+    size_t nCounted = 0;
+    for (size_t i = 0; i < (size_t) entityDensity.levelWidth(topLevel) * entityDensity.levelHeight(topLevel); i++)
+        nCounted += topCounts[i];
+    assert(nCounted == entitiesInWorld.size());
+    (void) nCounted;
+
+    level = std::min(level, entityDensity.levelCount() - 1);
+    densityArray.width = entityDensity.levelWidth(level);
+    densityArray.height = entityDensity.levelHeight(level);
+    densityArray.counts.assign(entityDensity.levelData(level),
+                               entityDensity.levelData(level) + ((size_t) densityArray.width * densityArray.height));
+}
+
+// Frees the memory used by the overview and the entity counts. They are built again when next loaded.
+void World::discardOverview() {
+    map->discardOverview();
+    entityDensity.clear();
+}
+
+// Adds amount to the entity count of the overview cell that holds the coordinate, if the counts exist.
+void World::adjustEntityDensity(const Coordinate &cord, int amount) {
+    if (entityDensity.isEmpty())
+        return;
+
+    const uint cellX = cord.x >> OVERVIEW_BASE_BITS, cellY = cord.y >> OVERVIEW_BASE_BITS;
+    entityDensity.baseCell(cellX, cellY) += amount;
+    entityDensity.markBaseChanged(cellX, cellY);
+}
+
+// Marks a tile to be loaded again by the next loadDisplayArray. Changes made through the World are
+//   marked automatically. Call this when an object changes how it looks without moving.
+void World::markTileDirty(const Coordinate &cord) {
+    // If every tile will be loaded anyway, there is nothing to record.
+    if (isDisplayStale || cordOutsideBound(map->maxCord(), cord))
+        return;
+
+    if (!isTileDirty.get(cord)) {
+        isTileDirty.set(cord, true);
+        dirtyTiles.push_back(getArrayIndex(cord, map->width()));
+    }
+
+    // Once an eighth of the world has changed, loading everything is cheaper than keeping the list.
+    if (dirtyTiles.size() >= (((size_t) map->width() * map->height()) / 8) + 64) {
+        this->clearDirtyTiles();
+        isDisplayStale = true;
+    }
+}
+
+// Makes the next loadDisplayArray load every tile.
+void World::invalidateDisplay() {
+    isDisplayStale = true;
+}
 
-            tmp.ForegroundInfo = entityData.object().getDisplayID();
-            tmp.ForegroundColor = entityData.object().getMaterial().color;
+// Loads every tile into the DisplayArray.
+void World::loadAllDisplayElements(DisplayArray &displayArray) {
+
+    // Load the DisplayArray with the info for the tiles. If the DisplayArray has the wrong dimensions,
+    //   the TileMap recreates it.
+    if ((displayArray.height != map->height()) || (displayArray.width != map->width()) || !displayArray.displayData)
+        map->loadDisplayArray(displayArray);
+    else
+        scheduler->parallelFor(0, map->height(), ROWS_PER_TASK, [this, &displayArray](uint begin, uint end, uint) {
+            map->loadDisplayArrayRows(displayArray, begin, end);
+        });
+
+    // Load all items' info into the DisplayArray, then all entities' info on top of it. Every tile
+    //   belongs to exactly one chunk, so chunks can be loaded at the same time. Only the most recently
+    //   added item on a tile is shown, as loadDisplayElement does.
+    scheduler->parallelFor(0, maxChunkNumber + 1, CHUNKS_PER_TASK, [this, &displayArray](uint begin, uint end, uint) {
+        for (uint chunk = begin; chunk < end; chunk++) {
+            for (uint slotIndex : itemsInChunks[chunk]) {
+                ObjectAndData<Iitem, IID> &itemData = itemsInWorld.atSlot(slotIndex).data;
+                if (!cordOutsideBound(map->maxCord(), itemData.coordinate()) &&
+                    (firstItemOnTile.get(itemData.coordinate()) == slotIndex)) {
+                    DisplayArrayElement &tmp = displayArray.displayData[getArrayIndex(itemData.coordinate(),
+                                                                                      displayArray.width)];
+
+                    tmp.ForegroundInfo = itemData.object().getDisplayID();
+                    tmp.ForegroundColor = itemData.object().getMaterial().color;
+                }
+            }
+        }
+    });
+
+    scheduler->parallelFor(0, maxChunkNumber + 1, CHUNKS_PER_TASK, [this, &displayArray](uint begin, uint end, uint) {
+        for (uint chunk = begin; chunk < end; chunk++) {
+            for (uint slotIndex : entitiesInChunks[chunk]) {
+                ObjectAndData<Ientity, EID> &entityData = entitiesInWorld.atSlot(slotIndex).data;
+                if (!cordOutsideBound(map->maxCord(), entityData.coordinate())) {
+                    DisplayArrayElement &tmp = displayArray.displayData[getArrayIndex(entityData.coordinate(),
+                                                                                      displayArray.width)];
+
+                    tmp.ForegroundInfo = entityData.object().getDisplayID();
+                    tmp.ForegroundColor = entityData.object().getMaterial().color;
+                }
+            }
         }
+    });
+}
+
+// Loads a single tile into the DisplayArray: the tile itself, then the most recently added item on it,
+//   then the entity on it.
+void World::loadDisplayElement(DisplayArray &displayArray, const uint tileIndex) {
+    const Coordinate cord{tileIndex % map->width(), tileIndex / map->width()};
+    DisplayArrayElement element = map->getTileDisplayElement(cord);
+
+    const uint itemSlotIndex = firstItemOnTile.get(cord);
+    if (itemSlotIndex != SLOT_NONE) {
+        Iitem &item = itemsInWorld.atSlot(itemSlotIndex).data.object();
+        element.ForegroundInfo = item.getDisplayID();
+        element.ForegroundColor = item.getMaterial().color;
     }
+
+    const uint entitySlotIndex = entityOnTile.get(cord);
+    if (entitySlotIndex != SLOT_NONE) {
+        Ientity &entity = entitiesInWorld.atSlot(entitySlotIndex).data.object();
+        element.ForegroundInfo = entity.getDisplayID();
+        element.ForegroundColor = entity.getMaterial().color;
+    }
+
+    displayArray.displayData[tileIndex] = element;
 }
 
-// Calls each entity's tick function.
+void World::clearDirtyTiles() {
+    for (uint tileIndex : dirtyTiles)
+        isTileDirty.set(Coordinate{tileIndex % map->width(), tileIndex / map->width()}, false);
+    dirtyTiles.clear();
+}
+
+// Calls the tick function of every entity that is due this tick. Entities do not change the world directly
+//   while they are ticked. Their moves, additions, and deletions are recorded in command buffers and applied
+//   together at the end of the tick, so the chunk index is never changed while it is being iterated.
+// Entities that are asleep are not ticked at all, so crowds of idle entities cost almost nothing.
 void World::tick() {
-    auto it = entitiesInWorld.begin();
+    WELT_TRACE_ZONE("World::tick");
+    WELT_PROFILE_ONLY(profiler.beginTick(tickNumber));
+    this->collectDueEntities();
+    WELT_PROFILE_ONLY(profiler.endPhase(TickPhase::COLLECT));
+
+    if (isTickParallel)
+        scheduler->parallelFor(0, (uint) dueEntities.size(), ENTITIES_PER_TASK,
+                               [this](uint begin, uint end, uint worker) {
+                                   this->tickDueEntities(begin, end, worker);
+                               });
+    else
+        this->tickDueEntities(0, (uint) dueEntities.size(), 0);
+    WELT_PROFILE_ONLY(profiler.endPhase(TickPhase::ENTITIES));
+
+    ++tickNumber;
+
+    this->commitIntents();
+    if (journal)
+        journal->endTick();
+    WELT_PROFILE_ONLY(profiler.endPhase(TickPhase::COMMIT));
+
+#ifdef WELT_PROFILE
+    for (auto &recorder : tickRecorders) {
+        profiler.current().queries.add(recorder->queryCounters());
+        recorder->queryCounters() = QueryCounters();
+    }
+    profiler.endTick();
+#endif
+}
+
+// Sets whether entities are ticked in parallel. During a tick, entities decide what to do against the
+//   world as it was at the start of the tick, and their changes are applied afterwards in a fixed order,
+//   so a parallel tick gives the same result as a serial one for any number of workers.
+void World::setParallelTick(bool isEnabled) {
+    isTickParallel = isEnabled;
+}
+
+// Sets the number of worker threads used by parallel ticks and by loadDisplayArray. If workerCount is
+//   zero, one worker per hardware thread is used.
+void World::setWorkerCount(uint workerCount) {
+    scheduler.reset(new TaskScheduler(workerCount));
+
+    tickRecorders.clear();
+    for (uint i = 0; i < scheduler->workerCount(); i++)
+        tickRecorders.emplace_back(new IntentRecorder(this, map));
+    profiler.setWorkerCount(scheduler->workerCount());
+}
+
+// Returns the number of worker threads, including the thread that calls tick.
+uint World::workerCount() const {
+    return scheduler->workerCount();
+}
+
+// Finds the entities due this tick, along with the energy they have gathered since they were last ticked,
+//   and sorts them by chunk so that neighbouring entities are ticked together.
+void World::collectDueEntities() {
+    WELT_TRACE_ZONE("collect due entities");
+    // Wake anything waiting on changes made outside of a tick.
+    this->wakeNearChangedChunks();
+
+    dueEntities.clear();
+    wakeWheel.collect(tickNumber, [this](EID id) {
+        return entitiesInWorld.find(id) ? entityWakeTick[SlotMap<Ientity, EID>::slotIndexOf(id)] : TICK_NEVER;
+    }, [this](EID id) {
+        const uint slotIndex = SlotMap<Ientity, EID>::slotIndexOf(id);
+
+        // An entity can be in the bucket more than once if it was rescheduled. Only tick it once.
+        if (entityLastTick[slotIndex] == tickNumber)
+            return;
+
+        const unsigned long long energy = (unsigned long long) givenEnergyPerTick *
+                                          (tickNumber - entityLastTick[slotIndex]);
+        entityLastTick[slotIndex] = tickNumber;
+        if (journal)
+            journal->touchEntity(slotIndex);
+        const Coordinate &position = entitiesInWorld.atSlot(slotIndex).data.coordinate();
+        dueEntities.push_back(DueEntity{getChunkNumberForCoordinate(position), slotIndex,
+                                        (uint) std::min(energy, 0xFFFFFFFFull)});
+    });
+
+    std::sort(dueEntities.begin(), dueEntities.end(), [](const DueEntity &a, const DueEntity &b) {
+        return (a.chunk < b.chunk) || ((a.chunk == b.chunk) && (a.slotIndex < b.slotIndex));
+    });
+}
 
-    // Iterate through the list, executing every entity's tick function.
-    while (it != entitiesInWorld.end()) {
-        Ientity *entityPtr = &((*it).object());
+// Ticks the due entities [begin, end), recording their changes with the given worker's recorder.
+void World::tickDueEntities(uint begin, uint end, uint worker) {
+    IntentRecorder &recorder = *tickRecorders[worker];
+
+    for (uint i = begin; i < end; i++) {
+        const DueEntity &due = dueEntities[i];
+        WELT_PROFILE_ONLY(const ProfileTime start = profileNow());
+        recorder.tickEntity(entitiesInWorld.atSlot(due.slotIndex).data, due.energy, due.chunk);
+        WELT_PROFILE_ONLY(profiler.recordEntity(worker, entityTypeOfSlot[due.slotIndex], start));
+    }
+}
 
-        // If the entity* is null, skip this element.
-        if (!entityPtr) {
-            ++it;
-            continue;
+// Applies the intents recorded during a tick as one batch, sorted by the chunk the recording entity
+//   started the tick in, and then by its EID, so that the updates to the chunk index and occupancy layers
+//   are grouped by area. Each entity's intents are applied in the order they were recorded. Moves are only
+//   applied if the entity is still where it expected to be and the destination is passable and free.
+void World::commitIntents() {
+    WELT_TRACE_ZONE("commit intents");
+    // Schedule every entity that was ticked. Entities deleted below leave stale entries that are skipped.
+    for (auto &recorder : tickRecorders) {
+        for (const WakeRequest &request : recorder->wakeRequests()) {
+            const uint slotIndex = SlotMap<Ientity, EID>::slotIndexOf(request.entity);
+            if (request.wakeTick == TICK_NEVER) {
+                entityWakeTick[slotIndex] = TICK_NEVER;
+                newChangeSleepers.push_back(request.entity);
+                if (journal)
+                    journal->touchEntity(slotIndex);
+            } else {
+                this->scheduleEntity(slotIndex, std::max(request.wakeTick, tickNumber));
+            }
         }
+        recorder->wakeRequests().clear();
+    }
+
+    pendingIntents.clear();
+    for (auto &recorder : tickRecorders) {
+        pendingIntents.insert(pendingIntents.end(), recorder->intents().begin(), recorder->intents().end());
+        recorder->intents().clear();
+    }
 
-        // Call the entity's tick function and store its returned state.
-        const EffectedType returnState = entityPtr->tick(this, map, *it, givenEnergyPerTick);
-
-        // If the entity indicated that it needs to be deleted, delete it.
-        if (returnState == EffectedType::DELETED) {
-            bool wasDeleted = this->deleteEntity(&it);
-            if (!wasDeleted)
-                ++it;
-        } else {
-            // Move to the next entity.
-            ++it;
+    std::stable_sort(pendingIntents.begin(), pendingIntents.end(), [](const Intent &a, const Intent &b) {
+        return (a.chunk < b.chunk) || ((a.chunk == b.chunk) && (a.emitter < b.emitter));
+    });
+
+    for (const Intent &intent : pendingIntents) {
+        switch (intent.type) {
+            case IntentType::MOVE: {
+                SlotMap<Ientity, EID>::Slot *slot = entitiesInWorld.find(intent.emitter);
+                const bool isMoved = slot && (slot->data.coordinate() == intent.from) &&
+                                     (this->tryMove(slot->data, intent.to, intent.passabilityRule) == MoveResult::MOVED);
+                WELT_PROFILE_ONLY(profiler.current().movesRejected += isMoved ? 0 : 1);
+                (void) isMoved;
+                break;
+            }
+            case IntentType::DAMAGE:
+                this->damageEntity(intent.targetEntity, intent.emitter, intent.damageAmount, intent.damageType);
+                break;
+            case IntentType::ADD_ENTITY:
+                if (!this->addEntity(intent.entity, intent.to))
+                    delete intent.entity;
+                break;
+            case IntentType::ADD_ITEM:
+                if (!this->addItem(intent.item, intent.to))
+                    delete intent.item;
+                break;
+            case IntentType::DELETE_ITEM:
+                this->deleteItem(intent.targetItem);
+                break;
+            case IntentType::DELETE_SELF:
+                this->deleteEntity(intent.emitter);
+                break;
         }
     }
 
-    ++tickNumber;
+    // Entities that went to sleep are registered after the changes are applied, so that a change made in
+    //   the same tick still wakes them.
+    for (EID id : newChangeSleepers) {
+        SlotMap<Ientity, EID>::Slot *slot = entitiesInWorld.find(id);
+        if (slot && (entityWakeTick[SlotMap<Ientity, EID>::slotIndexOf(id)] == TICK_NEVER))
+            changeSleepersInChunks[getChunkNumberForCoordinate(slot->data.coordinate())].push_back(id);
+    }
+    newChangeSleepers.clear();
+
+    this->wakeNearChangedChunks();
+}
+
+// Sets the tick the entity in the given slot is next due, and adds it to the timing wheel.
+void World::scheduleEntity(const uint slotIndex, const uint wakeTick) {
+    if (entityWakeTick[slotIndex] == wakeTick)
+        return;
+
+    entityWakeTick[slotIndex] = wakeTick;
+    if (wakeTick != TICK_NEVER)
+        wakeWheel.schedule(entitiesInWorld.atSlot(slotIndex).data.id(), wakeTick);
+    if (journal)
+        journal->touchEntity(slotIndex);
+}
+
+// Makes the entity in the given slot due no later than the given tick.
+void World::wakeEntity(const uint slotIndex, const uint wakeTick) {
+    if (entityWakeTick[slotIndex] > wakeTick)
+        this->scheduleEntity(slotIndex, wakeTick);
+}
+
+// Notes that something was added, deleted, or moved in the given chunk.
+void World::markChunkChanged(const uint chunkNumber) {
+    if (!isChunkChanged[chunkNumber]) {
+        isChunkChanged[chunkNumber] = true;
+        changedChunks.push_back(chunkNumber);
+    }
+}
+
+// Wakes, for the current tick number, the entities waiting for a change in or next to any chunk that changed.
+void World::wakeNearChangedChunks() {
+    for (uint chunkNumber : changedChunks) {
+        uint chunkX, chunkY;
+        DefaultGridLayout::cellCoordinates(chunkNumber, nChunksPerRow, chunkX, chunkY);
+
+        for (uint y = (chunkY == 0) ? 0 : chunkY - 1; (y <= chunkY + 1) && (y < nChunkRows); y++) {
+            for (uint x = (chunkX == 0) ? 0 : chunkX - 1; (x <= chunkX + 1) && (x < nChunksPerRow); x++) {
+                const uint neighbour = DefaultGridLayout::cellNumber(x, y, nChunksPerRow);
+                if (neighbour > maxChunkNumber)
+                    continue;
+
+                for (EID id : changeSleepersInChunks[neighbour]) {
+                    if (entitiesInWorld.find(id))
+                        this->wakeEntity(SlotMap<Ientity, EID>::slotIndexOf(id), tickNumber);
+                }
+                changeSleepersInChunks[neighbour].clear();
+            }
+        }
+
+        isChunkChanged[chunkNumber] = false;
+    }
+
+    changedChunks.clear();
 }
 
 // Moves an entity from one position to another. Returns true is successful.
-// If the entity does not exist or the cord is outside the World, return false.
+// If the entity does not exist, the destination is occupied, or the cord is outside the World, return false.
 bool World::moveEntity(const ObjectAndData<Ientity, EID> &entityData, Coordinate desiredPosition) {
     // If the desired coordinate is outsize the World or the entity pointer is NULL, return false.
     if (cordOutsideBound(map->maxCord(), desiredPosition))
         return false;
 
-    bool state = false;
+    // Find the entity's slot. If the given data does not match the stored data, return false.
+    SlotMap<Ientity, EID>::Slot *slot = entitiesInWorld.find(entityData.id());
+    if (!slot || !(slot->data == entityData))
+        return false;
+
+    // If another entity is on the desired tile, return false.
+    const uint occupant = entityOnTile.get(desiredPosition);
+    if ((occupant != SLOT_NONE) && (occupant != SlotMap<Ientity, EID>::slotIndexOf(entityData.id())))
+        return false;
+
+    relocateEntity(*slot, desiredPosition);
+
+    return true;
+}
+
+// Moves an entity to the desired tile if the tile's wall can be passed under the given rule and no other
+//   entity is on it. All checks and the move itself are done with one lookup of the entity.
+MoveResult World::tryMove(const ObjectAndData<Ientity, EID> &entityData, Coordinate desiredPosition,
+                          PassabilityRule passabilityRule) {
+    if (cordOutsideBound(map->maxCord(), desiredPosition))
+        return MoveResult::OUTSIDE_WORLD;
+
+    SlotMap<Ientity, EID>::Slot *slot = entitiesInWorld.find(entityData.id());
+    if (!slot || !(slot->data == entityData))
+        return MoveResult::NOT_FOUND;
+
+    if (!canPass(passabilityRule, map->wallMaterialAt(desiredPosition).materialType))
+        return MoveResult::BLOCKED;
+
+    const uint occupant = entityOnTile.get(desiredPosition);
+    if ((occupant != SLOT_NONE) && (occupant != SlotMap<Ientity, EID>::slotIndexOf(entityData.id())))
+        return MoveResult::OCCUPIED;
+
+    relocateEntity(*slot, desiredPosition);
+
+    return MoveResult::MOVED;
+}
+
+// Moves an entity that is known to be valid to a tile that is known to be free, updating the chunk
+//   index, the chunk populations, and the occupancy layer.
+void World::relocateEntity(SlotMap<Ientity, EID>::Slot &slot, Coordinate desiredPosition) {
+    const uint slotIndex = SlotMap<Ientity, EID>::slotIndexOf(slot.data.id());
 
     // Calculate what chunk the new and old positions are in.
     const uint newChunkNumber = getChunkNumberForCoordinate(desiredPosition);
-    const uint oldChunkNumber = getChunkNumberForCoordinate(entityData.coordinate());
+    const uint oldChunkNumber = getChunkNumberForCoordinate(slot.data.coordinate());
 
-    // Create reference variables to the new and old chunks to simplify later code.
-    list<ObjectAndData<Ientity, EID> *> &oldChunk = entitiesInChunks[oldChunkNumber];
-    list<ObjectAndData<Ientity, EID> *> &newChunk = entitiesInChunks[newChunkNumber];
+    markChunkChanged(oldChunkNumber);
+    markChunkChanged(newChunkNumber);
+    this->markTileDirty(slot.data.coordinate());
+    this->markTileDirty(desiredPosition);
+    this->adjustEntityDensity(slot.data.coordinate(), -1);
+    this->adjustEntityDensity(desiredPosition, 1);
 
-    // If the new position is not in the same chunk as the old position, we need to do some more work.
+    // If the new position is not in the same chunk as the old position, move the entity's index to the new chunk.
     if (newChunkNumber != oldChunkNumber) {
-        // Create a variable to store the original reference (the reference to the entity in the old chunk)
-        //   if we find it.
-        ObjectAndData<Ientity, EID> *originalObjectDataReference = nullptr;
-        bool wasOldReferenceFound = false;
-
-        // Scan through every entity in the chunk.
-        for (auto it = oldChunk.begin(); it != oldChunk.end(); ++it) {
-            // If we have found the entity reference in the old chunk, store it, remove
-            //   it from the old chunk, and set state to true.
-            if (**it == entityData) {
-                originalObjectDataReference = *it;
-                oldChunk.erase(it);
-                wasOldReferenceFound = true;
-                break;
-            }
-        }
-
-        // If the old reference was found and is valid, add the reference to the new chunk and set its position.
-        if (originalObjectDataReference && wasOldReferenceFound) {
-            isDataLocked = false;
-            originalObjectDataReference->mutCoordinate() = desiredPosition;
-            isDataLocked = true;
-            newChunk.push_back(originalObjectDataReference);
-            state = true;
-        }
-    } else {
-        // If the new position is in the same chunk as the old position, find
-        //   the reference and set the entity's position
-        for (auto &it : newChunk) {
-            if (*it == entityData) {
-                isDataLocked = false;
-                it->mutCoordinate() = desiredPosition;
-                isDataLocked = true;
-                state = true;
-                break;
-            }
-        }
+        removeFromChunk(entitiesInWorld, entitiesInChunks[oldChunkNumber], slot.chunkPosition);
+        addToChunk(entitiesInChunks[newChunkNumber], slot.chunkPosition, slotIndex);
+        adjustChunkPopulation(oldChunkNumber, entityTypeOfSlot[slotIndex], -1);
+        adjustChunkPopulation(newChunkNumber, entityTypeOfSlot[slotIndex], 1);
     }
 
-    // Return state. (true if movement was successful.)
-    return state;
+    if (journal)
+        journal->recordMoveEntity(slot.data.id(), slot.data.coordinate(), desiredPosition);
+
+    // Move the entity in the occupancy layer and set its position.
+    entityOnTile.set(slot.data.coordinate(), SLOT_NONE);
+    entityOnTile.set(desiredPosition, slotIndex);
+    isDataLocked = false;
+    slot.data.mutCoordinate() = desiredPosition;
+    isDataLocked = true;
+
+    WELT_PROFILE_ONLY(profiler.current().movesCommitted++);
 }
 
 // Returns the entity and/or the items at the given tile.
@@ -188,25 +630,21 @@ World::getObjectsOnTile(Coordinate cord, const bool getEntities, const bool getI
     if (cordOutsideBound(map->maxCord(), cord))
         return result;
 
-    // Find the chunk number for the coordinate and create a reference to that chunk.
-    const uint chunkNumber = getChunkNumberForCoordinate(cord);
-    vector<list<ObjectAndData<Ientity, EID> *> *> entityChunk;
-    vector<list<ObjectAndData<Iitem, IID> *> *> itemChunk;
-    entityChunk.push_back(&entitiesInChunks[chunkNumber]);
-    itemChunk.push_back(&itemsInChunks[chunkNumber]);
-
-    // If it was specified to look for entities, scan through the the entities in the
-    //   chunk, looking for an entity that is on the specified tile.
-    if (getEntities)
-        result.entitiesFound = std::make_shared<ObjectSearchCircle<Ientity, EID>>(entityChunk, cord, 0);
-
-    // If it was specified to look for items, scan through the the items in the
-    //   chunk, looking for items that are on the specified tile.
-    if (getItems)
-        result.itemsFound = std::make_shared<ObjectSearchCircle<Iitem, IID>>(itemChunk, cord, 0);
+    // A tile holds at most one entity, which the occupancy layer names directly.
+    if (getEntities) {
+        auto entitiesFound = std::make_shared<ObjectSearchList<Ientity, EID>>();
+        const uint slotIndex = entityOnTile.get(cord);
+        if (slotIndex != SLOT_NONE)
+            entitiesFound->add(entitiesInWorld.atSlot(slotIndex).data);
+        result.entitiesFound = entitiesFound;
+    }
 
-    if (!result.entitiesFound)
-        printf("Boi");
+    // The items on a tile are linked from the tile's first item.
+    if (getItems) {
+        auto itemsFound = std::make_shared<ObjectSearchList<Iitem, IID>>();
+        forEachItemOnTile(cord, [&](ObjectAndData<Iitem, IID> &itemData) { itemsFound->add(itemData); });
+        result.itemsFound = itemsFound;
+    }
 
     return result;
 }
@@ -217,178 +655,158 @@ bool World::addEntity(Ientity *entityToAdd, Coordinate cord) {
     if (cordOutsideBound(map->maxCord(), cord) || !entityToAdd)
         return false;
 
+    // If an entity is already on the destination tile, return false.
+    uint &occupant = entityOnTile.at(cord);
+    if (occupant != SLOT_NONE)
+        return false;
+
     // Find the number of the chunk that the destination coordinate is in.
     const uint chunkNumber = getChunkNumberForCoordinate(cord);
 
-    // Check every entity in the destination chunk to be sure that the destination tile is empty.
-    for (const auto &entity : entitiesInChunks[chunkNumber]) {
-        // If an entity is found at the destination, return false.
-        if (entity->coordinate() == cord)
-            return false;
+    // Store the entity and add its index to the chunk.
+    const EID id = entitiesInWorld.insert(entityToAdd, &isDataLocked, cord);
+    const uint slotIndex = SlotMap<Ientity, EID>::slotIndexOf(id);
+    SlotMap<Ientity, EID>::Slot &slot = entitiesInWorld.atSlot(slotIndex);
+    addToChunk(entitiesInChunks[chunkNumber], slot.chunkPosition, slotIndex);
+    occupant = slotIndex;
+
+    // Record the entity's type and count it in the chunk's population.
+    if (slotIndex >= entityTypeOfSlot.size())
+        entityTypeOfSlot.resize(slotIndex + 1);
+    entityTypeOfSlot[slotIndex] = entityToAdd->getObjectType();
+    adjustChunkPopulation(chunkNumber, entityTypeOfSlot[slotIndex], 1);
+    markChunkChanged(chunkNumber);
+    this->markTileDirty(cord);
+    this->adjustEntityDensity(cord, 1);
+
+    // The entity is first ticked on the next tick, with one tick's worth of energy.
+    if (slotIndex >= entityWakeTick.size()) {
+        entityWakeTick.resize(slotIndex + 1, TICK_NEVER);
+        entityLastTick.resize(slotIndex + 1, 0);
     }
-
-    // Set the entity's position and OID and add it to the World.
-    entitiesInWorld.emplace_back(entityToAdd, &isDataLocked, false, nextAvailableOID++, cord);
-    entitiesInChunks[chunkNumber].push_back(&entitiesInWorld.back());
+    entityWakeTick[slotIndex] = TICK_NEVER;
+    entityLastTick[slotIndex] = tickNumber - 1;
+    this->scheduleEntity(slotIndex, tickNumber);
+    WELT_PROFILE_ONLY(profiler.current().entitiesAdded++);
+    if (journal)
+        journal->recordAddEntity(id, cord, *entityToAdd);
 
     return true;
 }
 
-// Deletes an entity from the world based on it's pointer. Returns true if the entity was found and deleted.
-bool World::deleteEntity(list<ObjectAndData<Ientity, EID>>::iterator *it) {
-    auto globalIt = entitiesInWorld.begin();
-    bool foundInGlobal = false;
-
-    while (globalIt != entitiesInWorld.end()) {
-        if (*globalIt == **it) {
-            foundInGlobal = true;
-            break;
-        }
+// Deals damage to the entity with the given ID. Returns the entity's response, or NONE if it does not exist.
+EffectedType World::damageEntity(EID target, EID attacker, uint damageAmount, DamageType type) {
+    SlotMap<Ientity, EID>::Slot *slot = entitiesInWorld.find(target);
+    if (!slot)
+        return EffectedType::NONE;
 
-        ++globalIt;
+    // The damage can change the entity's state even if it is already due.
+    if (journal) {
+        journal->recordDamage(target, attacker, damageAmount, type);
+        journal->touchEntity(SlotMap<Ientity, EID>::slotIndexOf(target));
     }
 
-    if (!foundInGlobal)
-        return false;
-
-    const uint chunkNumber = getChunkNumberForCoordinate((**it).coordinate());
-    auto chunkIt = entitiesInChunks.at(chunkNumber).begin();
-    bool foundInChunk = false;
-
-    while (chunkIt != entitiesInChunks.at(chunkNumber).end()) {
-        if (**chunkIt == **it) {
-            foundInChunk = true;
-            break;
-        }
-
-        ++chunkIt;
-    }
+    // Let a sleeping entity react to being damaged.
+    this->wakeEntity(SlotMap<Ientity, EID>::slotIndexOf(target), tickNumber);
 
-    if (foundInChunk && foundInGlobal) {
-        delete &((**it).object());
-        *it = entitiesInWorld.erase(*it);
-        entitiesInChunks.at(chunkNumber).erase(chunkIt);
-
-        return true;
-    }
-
-    // If we could not find an entity with the given pointer, return false.
-    return false;
+    return slot->data.object().takeDamage(attacker, damageAmount, type);
 }
 
 // Deletes the entity with the specified objectID. Returns true if the entity was found and deleted.
 bool World::deleteEntity(EID objectID) {
-    auto globalIt = entitiesInWorld.begin();
-    bool foundInGlobal = false;
+    SlotMap<Ientity, EID>::Slot *slot = entitiesInWorld.find(objectID);
 
-    while (globalIt != entitiesInWorld.end()) {
-        if ((*globalIt).id() == objectID) {
-            foundInGlobal = true;
-            break;
-        }
-
-        ++globalIt;
-    }
-
-    if (!foundInGlobal)
+    // If we could not find an entity with the given ID, return false.
+    if (!slot)
         return false;
 
-    const uint chunkNumber = getChunkNumberForCoordinate((*globalIt).coordinate());
-    auto chunkIt = entitiesInChunks.at(chunkNumber).begin();
-    bool foundInChunk = false;
-
-    while (chunkIt != entitiesInChunks.at(chunkNumber).end()) {
-        if ((*chunkIt)->id() == objectID) {
-            foundInChunk = true;
-            break;
-        }
-
-        ++chunkIt;
-    }
+    const uint chunkNumber = getChunkNumberForCoordinate(slot->data.coordinate());
+    removeFromChunk(entitiesInWorld, entitiesInChunks[chunkNumber], slot->chunkPosition);
+    adjustChunkPopulation(chunkNumber, entityTypeOfSlot[SlotMap<Ientity, EID>::slotIndexOf(objectID)], -1);
+    entityOnTile.set(slot->data.coordinate(), SLOT_NONE);
+    markChunkChanged(chunkNumber);
+    this->markTileDirty(slot->data.coordinate());
+    this->adjustEntityDensity(slot->data.coordinate(), -1);
 
-    if (foundInChunk && foundInGlobal) {
-        delete &((*globalIt).object());
-        entitiesInWorld.erase(globalIt);
-        entitiesInChunks.at(chunkNumber).erase(chunkIt);
+    delete &(slot->data.object());
+    entitiesInWorld.erase(objectID);
+    WELT_PROFILE_ONLY(profiler.current().entitiesDeleted++);
+    if (journal)
+        journal->recordDeleteEntity(objectID);
 
-        return true;
-    }
-
-    // If we could not find an entity with the given pointer, return false.
-    return false;
+    return true;
 }
 
 // Returns the number of the chunk for the given coordinate.
 uint World::getChunkNumberForCoordinate(const Coordinate &cord) {
 
-    uint nChunksPerRow = map->width() / chunkSize;
-    if ((map->width() % chunkSize) > 0)
-        nChunksPerRow += 1;
-
     if (cordOutsideBound(map->maxCord(), cord))
         return maxChunkNumber;
 
     Coordinate chunkCord;
     chunkCord.y = cord.y / chunkSize;
     chunkCord.x = cord.x / chunkSize;
-    const uint chunkNumber = (chunkCord.y * nChunksPerRow) + chunkCord.x;
+    const uint chunkNumber = DefaultGridLayout::cellNumber(chunkCord.x, chunkCord.y, nChunksPerRow);
 
     assert(chunkNumber <= maxChunkNumber);
 
     return chunkNumber;
 }
 
-// Returns a vector of the numbers of the chunks in a given rectangle.
-vector<uint> World::getChunksInRect(const Coordinate &rectStart, uint height, uint width) {
-    vector<uint> result;
-    bool outside = false;
+// Appends the given slot index to a chunk and records its position in the chunk.
+void World::addToChunk(vector<uint> &chunk, uint &chunkPosition, const uint slotIndex) {
+    chunkPosition = (uint) chunk.size();
+    chunk.push_back(slotIndex);
+}
 
-    // If the minimum value of the rect is outside the world, return the overflow chunk (the max chunk.)
-    if (cordOutsideBound(map->maxCord(), rectStart)) {
-        result.push_back(maxChunkNumber);
-        return result;
-    }
+// Adds the given amount to the number of entities of the given type in a chunk.
+void World::adjustChunkPopulation(const uint chunkNumber, const uint objectType, const int amount) {
+    vector<uint> &counts = entityTypeCountsInChunks[chunkNumber];
+    if (objectType >= counts.size())
+        counts.resize(objectType + 1, 0);
 
-    // If the max value of the chunk is outside the bounds of the world, resize it so it
-    //   is, and set a flag so the overflow chunk can be included later.
-    if ((rectStart.y + height) > map->maxCord().y) {
-        height = map->maxCord().y - rectStart.y + 1;
-        outside = true;
-    }
+    assert((amount >= 0) || (counts[objectType] >= (uint) -amount));
+    counts[objectType] += amount;
+}
 
-    if ((rectStart.x + width) > map->maxCord().x) {
-        width = map->maxCord().x - rectStart.x + 1;
-        outside = true;
+// Adds an item slot to the front of the given tile's item list.
+void World::linkItemToTile(const uint slotIndex, const Coordinate &cord) {
+    if (slotIndex >= nextItemOnTile.size()) {
+        nextItemOnTile.resize(slotIndex + 1, SLOT_NONE);
+        previousItemOnTile.resize(slotIndex + 1, SLOT_NONE);
     }
 
-    const Coordinate rectEnd = Coordinate{(rectStart.x + width) - 1, (rectStart.y + height) - 1};
-    const Coordinate chunkEnd = Coordinate{rectEnd.x / chunkSize, rectEnd.y / chunkSize};
-    Coordinate chunkStart = Coordinate{rectStart.x / chunkSize, rectStart.y / chunkSize};
+    uint &head = firstItemOnTile.at(cord);
+    nextItemOnTile[slotIndex] = head;
+    previousItemOnTile[slotIndex] = SLOT_NONE;
+    if (head != SLOT_NONE)
+        previousItemOnTile[head] = slotIndex;
+    head = slotIndex;
+}
 
-    vector<Coordinate> chunkCordsInRect;
-    chunkCordsInRect.reserve((chunkStart.x - chunkEnd.x) * (chunkStart.y - chunkEnd.y));
+// Removes an item slot from the given tile's item list.
+void World::unlinkItemFromTile(const uint slotIndex, const Coordinate &cord) {
+    const uint next = nextItemOnTile[slotIndex];
+    const uint previous = previousItemOnTile[slotIndex];
 
-    while (chunkStart.x != (chunkEnd.x + 1)) {
-        for (Coordinate tmpCord = chunkStart; tmpCord.y != (chunkEnd.y + 1); tmpCord.y += 1) {
-            chunkCordsInRect.push_back(tmpCord);
-        }
-        chunkStart.x += 1;
-    }
+    if (previous != SLOT_NONE)
+        nextItemOnTile[previous] = next;
+    else
+        firstItemOnTile.set(cord, next);
 
-    for (const auto &it : chunkCordsInRect) {
-        Coordinate tmpCrd = Coordinate{it.x * chunkSize, it.y * chunkSize};
-        result.push_back(this->getChunkNumberForCoordinate(tmpCrd));
-    }
+    if (next != SLOT_NONE)
+        previousItemOnTile[next] = previous;
+}
 
-    // If any portion of the rect was outside the chunk, verify the the overflow chunk (the max chunk) is in the vector.
-    // If it is not, add it.
-    if (outside) {
-        if (result.back() != maxChunkNumber) {
-            result.push_back(maxChunkNumber);
-        }
-    }
+// Removes the slot index at the given position from a chunk by swapping the chunk's last index into its place.
+template<class Object, class ID_Type>
+void World::removeFromChunk(SlotMap<Object, ID_Type> &store, vector<uint> &chunk, const uint chunkPosition) {
+    assert(chunkPosition < chunk.size());
 
-    return result;
+    const uint lastSlotIndex = chunk.back();
+    chunk[chunkPosition] = lastSlotIndex;
+    store.atSlot(lastSlotIndex).chunkPosition = chunkPosition;
+    chunk.pop_back();
 }
 
 // Returns a SearchResult containing references to any entities and/or items found in the given circle.
@@ -396,29 +814,12 @@ SearchResult<Ientity, EID, Iitem, IID>
 World::getObjectsInCircle(Coordinate circleCenter, uint radius, bool getEntities, bool getItems) {
     SearchResult<Ientity, EID, Iitem, IID> result;
 
-    const uint rectSideLength = (radius * 2) + 1;
-    Coordinate rectEquivalent = Coordinate{circleCenter.x - radius, circleCenter.y - radius};
-
-    if (circleCenter.x < radius)
-        rectEquivalent.x = 0;
-
-    if (circleCenter.y < radius)
-        rectEquivalent.y = 0;
-
-    // Find the numbers of the chunks in the rectangle.
-    const vector<uint> cChunksInRect = this->getChunksInRect(rectEquivalent, rectSideLength, rectSideLength);
-    vector<list<ObjectAndData<Ientity, EID> *>*> entityChunks;
-    vector<list<ObjectAndData<Iitem, IID> *> *> itemChunks;
-    for (const auto &chunk : cChunksInRect) {
-        entityChunks.push_back(&entitiesInChunks[chunk]);
-        itemChunks.push_back(&itemsInChunks[chunk]);
-    }
-
     if (getEntities)
-        result.entitiesFound = std::make_shared<ObjectSearchCircle<Ientity, EID>>(entityChunks, circleCenter, radius);
+        result.entitiesFound = std::make_shared<ObjectSearchCircle<Ientity, EID>>(this->entityIndex(), circleCenter,
+                                                                                 radius);
 
     if (getItems)
-        result.itemsFound = std::make_shared<ObjectSearchCircle<Iitem, IID>>(itemChunks, circleCenter, radius);
+        result.itemsFound = std::make_shared<ObjectSearchCircle<Iitem, IID>>(this->itemIndex(), circleCenter, radius);
 
     return result;
 }
@@ -431,43 +832,97 @@ bool World::addItem(Iitem *itemPtr, Coordinate cord) {
         return false;
 
     // Add the item to the world and its chunk.
-    itemsInWorld.emplace_back(itemPtr, &isDataLocked, false, nextAvailableIID++, cord);
-    itemsInChunks[this->getChunkNumberForCoordinate(cord)].push_back(&itemsInWorld.back());
+    const IID id = itemsInWorld.insert(itemPtr, &isDataLocked, cord);
+    SlotMap<Iitem, IID>::Slot &slot = itemsInWorld.atSlot(SlotMap<Iitem, IID>::slotIndexOf(id));
+    addToChunk(itemsInChunks[this->getChunkNumberForCoordinate(cord)], slot.chunkPosition,
+               SlotMap<Iitem, IID>::slotIndexOf(id));
+    linkItemToTile(SlotMap<Iitem, IID>::slotIndexOf(id), cord);
+    markChunkChanged(this->getChunkNumberForCoordinate(cord));
+    this->markTileDirty(cord);
+    if (journal)
+        journal->recordAddItem(id, cord, *itemPtr);
 
     return true;
 }
 
 // Deletes a linked item completely from the world. Returns true if successful.
 bool World::deleteItem(IID itemToDelete) {
-    // If the given IID has not been assigned yes, return false;
-    if (itemToDelete >= nextAvailableIID)
+    SlotMap<Iitem, IID>::Slot *slot = itemsInWorld.find(itemToDelete);
+
+    // If the given IID does not reference an item in the world, return false.
+    if (!slot)
         return false;
 
-    bool itemWasFoundInWorld = false;
+    const uint chunkNumber = this->getChunkNumberForCoordinate(slot->data.coordinate());
+    removeFromChunk(itemsInWorld, itemsInChunks[chunkNumber], slot->chunkPosition);
+    unlinkItemFromTile(SlotMap<Iitem, IID>::slotIndexOf(itemToDelete), slot->data.coordinate());
+    markChunkChanged(chunkNumber);
+    this->markTileDirty(slot->data.coordinate());
 
-    auto worldIterator = itemsInWorld.begin();
-    while (worldIterator != itemsInWorld.end()) {
-        if ((*worldIterator).id() == itemToDelete) {
-            itemWasFoundInWorld = true;
-            break;
-        }
+    delete &(slot->data.object());
+    itemsInWorld.erase(itemToDelete);
+    if (journal)
+        journal->recordDeleteItem(itemToDelete);
 
-    }
+    return true;
+}
 
-    if (!itemWasFoundInWorld)
-        return false;
+// Returns a view of the entity chunk index for use by queries.
+ChunkIndexView<Ientity, EID> World::entityIndex() {
+    ChunkIndexView<Ientity, EID> view{&entitiesInWorld, &entitiesInChunks, chunkSize, nChunksPerRow, map->maxCord(),
+                                      &entityTypeCountsInChunks, &entityTypeOfSlot};
+    WELT_PROFILE_ONLY(view.queryCounters = &profiler.current().queries);
 
-    uint chunkNumber = this->getChunkNumberForCoordinate((*worldIterator).coordinate());
-    auto chunkIterator = itemsInChunks[chunkNumber].begin();
-    while (chunkIterator != itemsInChunks.at(chunkNumber).end()) {
-        if ((*chunkIterator)->id() == itemToDelete) {
-            delete &((*worldIterator).object());
-            itemsInWorld.erase(worldIterator);
-            itemsInChunks[chunkNumber].erase(chunkIterator);
-            return true;
-        }
+    return view;
+}
 
-    }
+// Returns a view of the item chunk index for use by queries.
+ChunkIndexView<Iitem, IID> World::itemIndex() {
+    ChunkIndexView<Iitem, IID> view{&itemsInWorld, &itemsInChunks, chunkSize, nChunksPerRow, map->maxCord(),
+                                    nullptr, nullptr};
+    WELT_PROFILE_ONLY(view.queryCounters = &profiler.current().queries);
+
+    return view;
+}
+
+// Returns the data of the entity on the given tile, or nullptr if the tile is empty or outside the world.
+ObjectAndData<Ientity, EID> *World::getEntityOnTile(Coordinate cord) {
+    if (cordOutsideBound(map->maxCord(), cord))
+        return nullptr;
+
+    const uint slotIndex = entityOnTile.get(cord);
+    if (slotIndex == SLOT_NONE)
+        return nullptr;
+
+    return &entitiesInWorld.atSlot(slotIndex).data;
+}
+
+// Returns the number of entities of the given type in the chunk that holds the given coordinate.
+//   Reads a counter, so it is cheap enough to use as a density estimate every tick.
+uint World::getChunkPopulation(Coordinate cord, uint objectType) {
+    if (cordOutsideBound(map->maxCord(), cord))
+        return 0;
+
+    const vector<uint> &counts = entityTypeCountsInChunks[getChunkNumberForCoordinate(cord)];
+    return (objectType < counts.size()) ? counts[objectType] : 0;
+}
+
+// Puts an entity to sleep until the given tick. Entities being ticked are given a stand-in for the world
+//   instead, so this is only used from outside of a tick.
+void World::sleepUntil(const ObjectAndData<Ientity, EID> &entityData, uint wakeTick) {
+    SlotMap<Ientity, EID>::Slot *slot = entitiesInWorld.find(entityData.id());
+    if (slot && (slot->data == entityData))
+        this->scheduleEntity(SlotMap<Ientity, EID>::slotIndexOf(entityData.id()), std::max(wakeTick, tickNumber));
+}
+
+// Puts an entity to sleep until something changes near it.
+void World::sleepUntilNearbyChange(const ObjectAndData<Ientity, EID> &entityData) {
+    SlotMap<Ientity, EID>::Slot *slot = entitiesInWorld.find(entityData.id());
+    if (!slot || !(slot->data == entityData))
+        return;
 
-    return false;
+    entityWakeTick[SlotMap<Ientity, EID>::slotIndexOf(entityData.id())] = TICK_NEVER;
+    if (journal)
+        journal->touchEntity(SlotMap<Ientity, EID>::slotIndexOf(entityData.id()));
+    changeSleepersInChunks[getChunkNumberForCoordinate(entityData.coordinate())].push_back(entityData.id());
 }
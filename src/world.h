@@ -2,28 +2,48 @@
 #define WORLD_H
 
 #include "ObjectSearchCircle.h"
+#include "ObjectSearchList.h"
 #include "IObjectSearch.h"
 #include "DisplayIDdef.h"
 #include "universal.h"
 #include "material.h"
 #include "TileMap.h"
+#include "TileLayer.h"
 #include "Iworld.h"
 #include "Ientity.h"
 #include "tile.h"
 #include "Iitem.h"
-#include <list>
+#include "SlotMap.h"
+#include "IntentRecorder.h"
+#include "TaskScheduler.h"
+#include "TimingWheel.h"
+#include "DisplayPyramid.h"
+#include "TickProfiler.h"
+#include "TraceWriter.h"
 #include <vector>
 #include <memory>
 #include <utility>
 #include <cassert>
 #include <algorithm>
 #include <stdexcept>
+#include <thread>
 
 using namespace std;
 
+// The number of chunks, rows of tiles, and entities handed out at a time to the scheduler's workers.
+const uint CHUNKS_PER_TASK = 4;
+const uint ROWS_PER_TASK = 16;
+const uint ENTITIES_PER_TASK = 64;
+
+class DeltaJournal;
+
 class World : public Iworld<Ientity, EID, Iitem, IID> {
+    friend class WorldSnapshot;
+    friend class DeltaJournal;
+    friend class JournalReplay;
+
 public:
-    World(uint height, uint width, uint energyPerTick);
+    World(uint height, uint width, uint energyPerTick, bool isMapPaged = false);
 
     ~World() override;
 
@@ -34,15 +54,43 @@ public:
 
     uint &energyPerTick() { return givenEnergyPerTick; }
 
+    uint getEnergyPerTick() override { return givenEnergyPerTick; }
+
     void loadDisplayArray(DisplayArray &displayArray);
 
+    void loadDisplayArray(DisplayArray &displayArray, const ViewRect &view);
+
+    void loadOverview(DisplayArray &displayArray, uint level);
+
+    void loadEntityDensity(DensityArray &densityArray, uint level);
+
+    void discardOverview();
+
+    void markTileDirty(const Coordinate &cord);
+
+    void invalidateDisplay();
+
     void tick();
 
+    void setParallelTick(bool isEnabled);
+
+    void setWorkerCount(uint workerCount = 0);
+
+    uint workerCount() const;
+
+    // Returns the stats of recent ticks. They are only collected if WELT_PROFILE is defined.
+    const TickProfiler &stats() const { return profiler; }
+
+    void resetStats() { profiler.reset(); }
+
     bool moveEntity(const ObjectAndData<Ientity, EID> &entityData, Coordinate desiredPosition) override;
 
+    MoveResult tryMove(const ObjectAndData<Ientity, EID> &entityData, Coordinate desiredPosition,
+                       PassabilityRule passabilityRule) override;
+
     bool addEntity(Ientity *entityToAdd, Coordinate cord) override;
 
-    bool deleteEntity(list<ObjectAndData<Ientity, EID>>::iterator *it);
+    EffectedType damageEntity(EID target, EID attacker, uint damageAmount, DamageType type) override;
 
     bool deleteEntity(EID objectID);
 
@@ -55,20 +103,110 @@ public:
 
     bool deleteItem(IID itemToDelete) override;
 
+    ChunkIndexView<Ientity, EID> entityIndex() override;
+
+    ChunkIndexView<Iitem, IID> itemIndex() override;
+
+    uint getChunkPopulation(Coordinate cord, uint objectType) override;
+
+    ObjectAndData<Ientity, EID> *getEntityOnTile(Coordinate cord) override;
+
+    void sleepUntil(const ObjectAndData<Ientity, EID> &entityData, uint wakeTick) override;
+
+    void sleepUntilNearbyChange(const ObjectAndData<Ientity, EID> &entityData) override;
+
+    template<class Visitor>
+    void forEachItemOnTile(Coordinate cord, Visitor &&visitor);
+
 private:
+    struct DueEntity {
+        uint chunk, slotIndex, energy;
+    };
+
+    void collectDueEntities();
+
+    void tickDueEntities(uint begin, uint end, uint worker);
+
+    void commitIntents();
+
+    void scheduleEntity(uint slotIndex, uint wakeTick);
+
+    void wakeEntity(uint slotIndex, uint wakeTick);
+
+    void markChunkChanged(uint chunkNumber);
+
+    void wakeNearChangedChunks();
+
+    void loadAllDisplayElements(DisplayArray &displayArray);
+
+    void loadDisplayElement(DisplayArray &displayArray, uint tileIndex);
+
+    void clearDirtyTiles();
+
+    void adjustEntityDensity(const Coordinate &cord, int amount);
+
     uint getChunkNumberForCoordinate(const Coordinate &cord);
 
-    vector<uint> getChunksInRect(const Coordinate &rectStart, uint height, uint width);
+    void addToChunk(vector<uint> &chunk, uint &chunkPosition, uint slotIndex);
+
+    void adjustChunkPopulation(uint chunkNumber, uint objectType, int amount);
+
+    void relocateEntity(SlotMap<Ientity, EID>::Slot &slot, Coordinate desiredPosition);
+
+    template<class Object, class ID_Type>
+    void removeFromChunk(SlotMap<Object, ID_Type> &store, vector<uint> &chunk, uint chunkPosition);
+
+    void linkItemToTile(uint slotIndex, const Coordinate &cord);
+
+    void unlinkItemFromTile(uint slotIndex, const Coordinate &cord);
 
     TileMap *map;
-    uint givenEnergyPerTick, tickNumber, chunkSize, maxChunkNumber;
-    EID nextAvailableOID;
-    EID nextAvailableIID;
+    uint givenEnergyPerTick, tickNumber, chunkSize, nChunksPerRow, nChunkRows, maxChunkNumber;
     bool isDataLocked;
-    list<ObjectAndData<Ientity, EID>> entitiesInWorld;
-    vector<list<ObjectAndData<Ientity, EID> *>> entitiesInChunks;
-    list<ObjectAndData<Iitem, IID>> itemsInWorld;
-    vector<list<ObjectAndData<Iitem, IID> *>> itemsInChunks;
+    bool isTickParallel;
+    unique_ptr<TaskScheduler> scheduler;
+    vector<unique_ptr<IntentRecorder>> tickRecorders; // One per scheduler worker.
+    vector<Intent> pendingIntents;
+    SlotMap<Ientity, EID> entitiesInWorld;
+    vector<vector<uint>> entitiesInChunks;
+    vector<vector<uint>> entityTypeCountsInChunks;
+    vector<uint> entityTypeOfSlot;
+    TimingWheel<EID> wakeWheel;
+    vector<uint> entityWakeTick;                  // Per entity slot, the tick it is next due, or TICK_NEVER.
+    vector<uint> entityLastTick;                  // Per entity slot, the last tick it was ticked.
+    vector<vector<EID>> changeSleepersInChunks;   // Entities waiting for a change near each chunk.
+    vector<EID> newChangeSleepers;
+    vector<uint> changedChunks;
+    vector<bool> isChunkChanged;
+    vector<DueEntity> dueEntities;
+    SlotMap<Iitem, IID> itemsInWorld;
+    vector<vector<uint>> itemsInChunks;
+    TileLayer<uint> entityOnTile;    // The slot of the entity on each tile, or SLOT_NONE.
+    TileLayer<uint> firstItemOnTile; // The slot of the most recently added item on each tile, or SLOT_NONE.
+    vector<uint> nextItemOnTile;     // Per item slot, the slot of the next item on the same tile, or SLOT_NONE.
+    vector<uint> previousItemOnTile; // Per item slot, the slot of the previous item on the same tile, or SLOT_NONE.
+    vector<uint> dirtyTiles;         // Tiles whose objects changed since the last loadDisplayArray.
+    TileLayer<bool> isTileDirty;
+    bool isDisplayStale;             // If true, the next loadDisplayArray loads every tile.
+    DisplayArrayElement *lastDisplayData; // The DisplayArray data loaded last time.
+    DisplayPyramid<uint> entityDensity;   // Empty until the first loadEntityDensity.
+    TickProfiler profiler;
+    DeltaJournal *journal; // Records every change while a DeltaJournal is recording, or nullptr.
 };
 
+// Calls visitor(ObjectAndData<Iitem, IID> &) for every item on the given tile, most recently added first.
+template<class Visitor>
+void World::forEachItemOnTile(Coordinate cord, Visitor &&visitor) {
+    if (cordOutsideBound(map->maxCord(), cord))
+        return;
+
+    uint slotIndex = firstItemOnTile.get(cord);
+    while (slotIndex != SLOT_NONE) {
+        // Read the link before visiting, so the visitor may delete the item it is given.
+        const uint nextSlotIndex = nextItemOnTile[slotIndex];
+        visitor(itemsInWorld.atSlot(slotIndex).data);
+        slotIndex = nextSlotIndex;
+    }
+}
+
 #endif
\ No newline at end of file